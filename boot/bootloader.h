@@ -0,0 +1,53 @@
+/*
+ *  Protocol of the 'Open Game Pad' HID bootloader.
+ *
+ *  Shared by the bootloader, the firmware and the host side uploader, so this header must not depend on AVR headers.
+ *
+ *  The bootloader enumerates as a HID device with a single vendor defined feature report. Each SET_REPORT carries one
+ *  flash page: [address low][address high][BOOT_PAGE_SIZE bytes of data]. The page is erased and programmed after the
+ *  transfer is complete, while the host waits before sending the next report. A report with the address BOOT_ADDR_LEAVE
+ *  starts the application. A report arriving while the previous page still waits to be programmed is stalled and has
+ *  to be sent again. GET_REPORT returns [page size][bootloader address low][bootloader address high][checksum low]
+ *  [checksum high], the checksum being the CRC-16 (CCITT, start value 0xFFFF, _crc_ccitt_update() of avr-libc) of the
+ *  flash page programmed last, so the host can compare it with what it sent.
+ *
+ *  The ATtiny85 has no bootloader section, so the bootloader patches the reset vector of the application to point to
+ *  itself and keeps the original one as an 'rjmp' in the last word before the bootloader (the trampoline).
+ * */
+
+#ifndef __BOOTLOADER_H__
+#define __BOOTLOADER_H__
+
+// Bootloader USB identity: obdev's shared VID/PID pair for HID devices, told apart by the device name.
+#define BOOT_VID            0x16c0
+#define BOOT_PID            0x05df
+// Manufacturer and product strings, the same as USB_CFG_VENDOR_NAME and USB_CFG_DEVICE_NAME in boot/usbconfig.h.
+#define BOOT_VENDOR_NAME    "notFtech"
+#define BOOT_DEVICE_NAME    "OGPadBoot"
+// Flash geometry of the ATtiny85.
+#define BOOT_FLASH_SIZE     8192
+#define BOOT_PAGE_SIZE      64
+// Size of the page report and of the info report.
+#define BOOT_REPORT_SIZE    (2 + BOOT_PAGE_SIZE)
+#define BOOT_INFO_SIZE      5
+// Page address that asks the bootloader to start the application.
+#define BOOT_ADDR_LEAVE     0xFFFF
+// Delay in milliseconds the host keeps after each page report, while the CPU is halted by the page erase and write.
+#define BOOT_PAGE_DELAY     12
+
+// Vendor request of the firmware that restarts the pad into the bootloader.
+#define BOOT_RQ_ENTER       3
+// RAM location and value of the magic which asks the bootloader to stay after the next reset. The location is only
+// written by the firmware right before its watchdog reset and read by the bootloader before its RAM is initialized.
+#define BOOT_MAGIC_ADDR     0x60
+#define BOOT_MAGIC          0xB007
+
+// 'rjmp' instruction at byte address 'from' which jumps to byte address 'to'. On 8 kB parts it wraps around the flash.
+#define BOOT_RJMP(from, to)         (0xC000 | ((((to) - (from)) / 2 - 1) & 0x0FFF))
+// Byte address the 'rjmp' instruction 'word' at byte address 'from' jumps to.
+#define BOOT_RJMP_TARGET(from, word) \
+    (((from) + 2 + 2 * (((int) ((word) & 0x0FFF) ^ 0x0800) - 0x0800)) & (BOOT_FLASH_SIZE - 1))
+// Returns non zero if the word is an 'rjmp' instruction.
+#define BOOT_IS_RJMP(word)          (((word) & 0xF000) == 0xC000)
+
+#endif
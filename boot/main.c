@@ -0,0 +1,234 @@
+/*
+ *  HID bootloader for 'Open Game Pad'
+ *
+ *  The bootloader lives at the end of the flash (BOOT_ADDR) and receives the firmware as a stream of HID feature
+ *  reports, one flash page per report (see bootloader.h). Incoming bytes go straight into the SPM page buffer, so the
+ *  page is never held in RAM. The ATtiny85 halts the CPU while a page is erased or written, therefore both are done in
+ *  the gap after the status stage of the report, while the host waits before streaming the next one.
+ *
+ *  The interrupt vectors belong to the firmware. The bootloader keeps interrupts disabled and calls the V-USB interrupt
+ *  routine itself as soon as the INT0 flag is raised.
+ * */
+
+#include<avr/pgmspace.h>
+#include<avr/interrupt.h>
+#include<avr/boot.h>
+#include<avr/wdt.h>
+#include<avr/io.h>
+#include<util/delay.h>
+#include<util/crc16.h>
+
+#include "../usbdrv/usbdrv.h"
+#include "../src/osccal.h"
+#include "bootloader.h"
+
+// Word right below the bootloader holding the jump into the firmware, and the page it belongs to.
+#define BOOT_TRAMPOLINE     (BOOT_ADDR - 2)
+#define BOOT_LAST_PAGE      (BOOT_ADDR - BOOT_PAGE_SIZE)
+// Idle polling windows (about 2 ms each) without a page report before a valid firmware is started again.
+#define BOOT_TIMEOUT        2500
+
+_Static_assert(SPM_PAGESIZE == BOOT_PAGE_SIZE, "page size of the protocol does not match the device");
+_Static_assert(BOOT_ADDR % SPM_PAGESIZE == 0, "bootloader must start at a page boundary");
+
+// Gap actions, done once the host received the status of the last report.
+enum { BOOT_NONE, BOOT_WRITE, BOOT_LEAVE };
+
+// V-USB interrupt routine, renamed in usbconfig.h.
+void bootUsbInterrupt(void);
+// Transmit status of the driver. Has bit 4 set while nothing waits for the host.
+extern volatile uchar usbTxLen;
+
+// Reset vector of a blank pad, linked to address 0. The first page of every firmware upload replaces it.
+const uint16_t bootReset __attribute__((used, section(".bootreset"))) = BOOT_RJMP(0, BOOT_ADDR);
+
+// Info report: page size, the address of the bootloader and the checksum of the page programmed last.
+static uchar INFO[BOOT_INFO_SIZE] = { BOOT_PAGE_SIZE, BOOT_ADDR & 0xFF, BOOT_ADDR >> 8 };
+// Address of the page in the current report and the position inside the report.
+static uint16_t ADDR;
+static uchar POS;
+// Low byte of the word being received.
+static uchar LOW;
+// Reset vector of the firmware received with page 0. Zero until page 0 is written.
+static uint16_t APP_RESET;
+// Action waiting for the next gap.
+static uchar PENDING;
+// Idle polling windows since the last page report.
+static uint16_t IDLE;
+
+/*
+ * Bootloader report descriptor.
+ *
+ * One vendor defined feature report which carries a page address and a page of data.
+ * */
+PROGMEM const char usbDescriptorHidReport[USB_CFG_HID_REPORT_DESCRIPTOR_LENGTH] = {
+    0x06, 0x00, 0xFF,              // USAGE_PAGE (Vendor Defined Page 1)
+    0x09, 0x01,                    // USAGE (Vendor Usage 1)
+    0xA1, 0x01,                    // COLLECTION (Application)
+    0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
+    0x26, 0xFF, 0x00,              //   LOGICAL_MAXIMUM (255)
+    0x75, 0x08,                    //   REPORT_SIZE (8)
+    0x95, BOOT_REPORT_SIZE,        //   REPORT_COUNT (66)
+    0x09, 0x00,                    //   USAGE (Undefined)
+    0xB2, 0x02, 0x01,              //   FEATURE (Data,Var,Abs,Buf)
+    0xC0                           // END_COLLECTION
+};
+
+/*
+ * Runs from .init3, before the RAM is initialized, while the magic left by the firmware is still in place.
+ *
+ * The result is kept in GPIOR0, because the RAM is cleared right after.
+ * */
+void bootMagicCheck(void) __attribute__((naked, used, section(".init3")));
+void bootMagicCheck(void) {
+    volatile uint16_t *magic = (volatile uint16_t *) BOOT_MAGIC_ADDR;
+
+    GPIOR0 = *magic == BOOT_MAGIC;
+    *magic = 0;
+}
+
+// Calibrates the RC oscillator after every USB reset.
+void hadUsbReset(void) {
+    osccalCalibrate();
+}
+
+// Returns non zero if a firmware was installed completely.
+static uchar appValid(void) {
+    return pgm_read_word(BOOT_TRAMPOLINE) != 0xFFFF;
+}
+
+// Jumps into the firmware through the trampoline.
+static void __attribute__((noreturn)) appJump(void) {
+    ((void (*)(void)) (BOOT_TRAMPOLINE / 2))();
+    for(;;);
+}
+
+// Programs the page received last. Called in a gap, the CPU is halted for about 9 ms.
+static void pageWrite(void) {
+    uint16_t crc = 0xFFFF;
+    uchar i;
+
+    // A new image starts with page 0. Until it is complete, the old trampoline must not start a half written firmware.
+    if(ADDR == 0) {
+        boot_page_erase(BOOT_LAST_PAGE);
+        boot_spm_busy_wait();
+    }
+    boot_page_erase(ADDR);
+    boot_spm_busy_wait();
+    boot_page_write(ADDR);
+    boot_spm_busy_wait();
+
+    // The host reads the page back through this checksum in the info report.
+    for(i = 0; i < BOOT_PAGE_SIZE; i++) crc = _crc_ccitt_update(crc, pgm_read_byte(ADDR + i));
+    INFO[3] = crc;
+    INFO[4] = crc >> 8;
+}
+
+// Writes the trampoline if a new firmware was received and restarts into it.
+static void __attribute__((noreturn)) appStart(void) {
+    uchar i;
+
+    if(APP_RESET) {
+        SPMCSR = 1 << CTPB;
+        for(i = 0; i < BOOT_PAGE_SIZE - 2; i += 2)
+            boot_page_fill(BOOT_LAST_PAGE + i, pgm_read_word(BOOT_LAST_PAGE + i));
+        boot_page_fill(BOOT_TRAMPOLINE, BOOT_RJMP(BOOT_TRAMPOLINE, BOOT_RJMP_TARGET(0, APP_RESET)));
+        boot_page_erase(BOOT_LAST_PAGE);
+        boot_spm_busy_wait();
+        boot_page_write(BOOT_LAST_PAGE);
+        boot_spm_busy_wait();
+    }
+
+    // The firmware is started from a clean reset. Without the magic the bootloader jumps into it right away.
+    usbDeviceDisconnect();
+    wdt_enable(WDTO_15MS);
+    for(;;);
+}
+
+// Handles the HID class requests of the host.
+usbMsgLen_t usbFunctionSetup(uchar raw[8]) {
+    usbRequest_t *req = (void *) raw;
+
+    if((req->bmRequestType & USBRQ_TYPE_MASK) == USBRQ_TYPE_CLASS){
+        if(req->bRequest == USBRQ_HID_GET_REPORT){
+            usbMsgPtr = (usbMsgPtr_t) INFO;
+            return sizeof(INFO);
+        }else if(req->bRequest == USBRQ_HID_SET_REPORT){
+            // A report arriving before the previous page was programmed is stalled in usbFunctionWrite(), the page
+            // buffer still holds that page.
+            POS = 0;
+            if(!PENDING) SPMCSR = 1 << CTPB;    // Clearing what an aborted report could leave in the page buffer.
+            return USB_NO_MSG;
+        }
+    }
+
+    return 0;
+}
+
+// Receives the page report in chunks of up to 8 bytes and moves the data straight into the page buffer.
+uchar usbFunctionWrite(uchar *data, uchar len) {
+    uint16_t word;
+    uchar i;
+
+    if(PENDING) return 0xff;
+    for(i = 0; i < len && POS < BOOT_REPORT_SIZE; i++, POS++) {
+        if(POS < 2) {                       // Page address, low byte first.
+            ((uchar *) &ADDR)[POS] = data[i];
+            if(POS == 1 && ADDR != BOOT_ADDR_LEAVE && (ADDR % BOOT_PAGE_SIZE || ADDR >= BOOT_ADDR))
+                return 0xff;                // The bootloader never overwrites itself.
+        }else if(!(POS & 1)) {
+            LOW = data[i];
+        }else if(ADDR != BOOT_ADDR_LEAVE) {
+            word = LOW | data[i] << 8;
+            // The reset vector of the firmware is replaced by a jump to the bootloader and kept for the trampoline.
+            if(ADDR == 0 && POS == 3) {
+                APP_RESET = BOOT_IS_RJMP(word) ? word : 0;
+                word = BOOT_RJMP(0, BOOT_ADDR);
+            }
+            boot_page_fill(ADDR + POS - 3, word);
+        }
+    }
+
+    if(POS < BOOT_REPORT_SIZE) return 0;
+    PENDING = ADDR == BOOT_ADDR_LEAVE ? BOOT_LEAVE : BOOT_WRITE;
+    IDLE = 0;
+    return 1;
+}
+
+int __attribute__((noreturn)) main(void) {
+    uint16_t n;
+
+    // Watchdog stays enabled after a watchdog reset until WDRF is cleared.
+    MCUSR = 0;
+    wdt_disable();
+
+    // Without the magic a complete firmware is started right away, so the bootloader adds no delay to the boot.
+    if(!GPIOR0 && appValid()) appJump();
+
+    usbDeviceDisconnect();                 // Forcing re-enumeration as the bootloader.
+    _delay_ms(250);
+    usbDeviceConnect();
+    usbInit();
+    USB_INTR_ENABLE &= ~(1 << USB_INTR_ENABLE_BIT);  // INT0 is polled, its vector belongs to the firmware.
+
+    for(;;) {
+        // Waiting up to about 2 ms for the next packet. The loop is short enough to catch the SYNC pattern in time.
+        n = 4096;
+        do {
+            if(USB_INTR_PENDING & (1 << USB_INTR_PENDING_BIT)) {
+                bootUsbInterrupt();
+                break;
+            }
+        } while(--n);
+        usbPoll();
+
+        // The host got the status of the last report and waits, which is the gap for the slow flash operations.
+        if(PENDING && (usbTxLen & 0x10)) {
+            if(PENDING == BOOT_LEAVE) appStart();
+            pageWrite();
+            PENDING = BOOT_NONE;
+        }
+
+        if(!n && appValid() && ++IDLE == BOOT_TIMEOUT) appStart();
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ *  Configuration header of V-USB for the 'Open Game Pad' bootloader.
+ *
+ *  Same hardware as the firmware (see src/usbconfig.h for the full documentation of every option), but everything that
+ *  is not needed to receive feature reports is disabled to keep the bootloader small. The bootloader runs with
+ *  interrupts disabled, so the driver's interrupt routine is renamed and called by polling the INT0 flag.
+ * */
+
+#ifndef __usbconfig_h_included__
+#define __usbconfig_h_included__
+
+/* ---------------------------- Hardware Config ---------------------------- */
+
+#define USB_CFG_IOPORTNAME      B
+#define USB_CFG_DMINUS_BIT      1
+#define USB_CFG_DPLUS_BIT       2
+#define USB_CFG_CLOCK_KHZ       (F_CPU/1000)
+#define USB_CFG_CHECK_CRC       0
+
+/* --------------------------- Functional Range ---------------------------- */
+
+#define USB_CFG_HAVE_INTRIN_ENDPOINT    1
+/* HID requires an interrupt-in endpoint, but nothing is ever sent through it.
+ */
+#define USB_CFG_HAVE_INTRIN_ENDPOINT3   0
+#define USB_CFG_EP3_NUMBER              3
+#define USB_CFG_IMPLEMENT_HALT          0
+#define USB_CFG_SUPPRESS_INTR_CODE      1
+#define USB_CFG_INTR_POLL_INTERVAL      100
+/* The host polls the unused endpoint as rarely as possible. Every poll that
+ * arrives while a flash page is programmed is lost.
+ */
+#define USB_CFG_IS_SELF_POWERED         0
+#define USB_CFG_MAX_BUS_POWER           100
+#define USB_CFG_IMPLEMENT_FN_WRITE      1
+#define USB_CFG_IMPLEMENT_FN_READ       0
+#define USB_CFG_IMPLEMENT_FN_WRITEOUT   0
+#define USB_CFG_HAVE_FLOWCONTROL        0
+#define USB_CFG_DRIVER_FLASH_PAGE       0
+#define USB_CFG_LONG_TRANSFERS          0
+#define USB_RESET_HOOK(resetStarts)     if(!resetStarts){hadUsbReset();}
+#define USB_COUNT_SOF                   0
+#define USB_CFG_CHECK_DATA_TOGGLING     0
+#define USB_CFG_HAVE_MEASURE_FRAME_LENGTH   1
+#define USB_USE_FAST_CRC                0
+
+/* -------------------------- Device Description --------------------------- */
+
+#define USB_CFG_VENDOR_ID       0xc0, 0x16 /* = 0x16c0 = 5824 = voti.nl */
+#define USB_CFG_DEVICE_ID       0xdf, 0x05 /* obdev's shared PID for HIDs */
+#define USB_CFG_DEVICE_VERSION  0x00, 0x01
+#define USB_CFG_VENDOR_NAME     'n', 'o', 't', 'F', 't', 'e', 'c', 'h'
+#define USB_CFG_VENDOR_NAME_LEN 8
+#define USB_CFG_DEVICE_NAME     'O', 'G', 'P', 'a', 'd', 'B', 'o', 'o', 't'
+#define USB_CFG_DEVICE_NAME_LEN 9
+#define USB_CFG_DEVICE_CLASS        0
+#define USB_CFG_DEVICE_SUBCLASS     0
+#define USB_CFG_INTERFACE_CLASS     3
+#define USB_CFG_INTERFACE_SUBCLASS  0
+#define USB_CFG_INTERFACE_PROTOCOL  0
+#define USB_CFG_HID_REPORT_DESCRIPTOR_LENGTH 22
+
+#define USB_CFG_DESCR_PROPS_DEVICE                  0
+#define USB_CFG_DESCR_PROPS_CONFIGURATION           0
+#define USB_CFG_DESCR_PROPS_STRINGS                 0
+#define USB_CFG_DESCR_PROPS_STRING_0                0
+#define USB_CFG_DESCR_PROPS_STRING_VENDOR           0
+#define USB_CFG_DESCR_PROPS_STRING_PRODUCT          0
+#define USB_CFG_DESCR_PROPS_STRING_SERIAL_NUMBER    0
+#define USB_CFG_DESCR_PROPS_HID                     0
+#define USB_CFG_DESCR_PROPS_HID_REPORT              0
+#define USB_CFG_DESCR_PROPS_UNKNOWN                 0
+
+#define usbMsgPtr_t unsigned short
+
+/* ----------------------- Optional MCU Description ------------------------ */
+
+#define USB_INTR_VECTOR         bootUsbInterrupt
+/* The driver's interrupt routine becomes a plain function. It is called from
+ * the main loop of the bootloader as soon as the INT0 flag is raised, because
+ * the interrupt vectors belong to the application.
+ */
+
+#ifndef __ASSEMBLER__
+extern void hadUsbReset(void);
+#endif
+
+#endif /* __usbconfig_h_included__ */
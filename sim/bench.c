@@ -0,0 +1,202 @@
+/*
+ *  Driver benchmark firmware of 'Open Game Pad', run by sim/ogbench.
+ *
+ *  Each case prepares the driver state, then runs one call of a driver hot path between BENCH_START() and BENCH_STOP().
+ *  The runner counts the cycles between the two markers and names the case after the function the start marker is in.
+ *  The first case holds nothing but the markers, its cycles are taken off all the others, so each result is the call
+ *  with its arguments and return. Interrupts stay off all the time.
+ *
+ *  The driver is included as source to reach its static functions. The ones measured are kept out of line, the firmware
+ *  inlines usbBuildTxBlock() and usbDeviceRead() into usbPoll(), which then saves the call and return of those.
+ *
+ *  The axis filter is linked as it is built for the firmware and measured for one call over all axes, at rest and on a
+ *  full stroke of every axis, the cheapest and the dearest path through its loop.
+ * */
+
+#include<avr/io.h>
+#include<avr/interrupt.h>
+#include<avr/pgmspace.h>
+#include<avr/sleep.h>
+#include<string.h>
+
+#include "usbdrv.h"
+#include "ogpad.h"
+#include "filter.h"
+#include "settings.h"
+
+#if OG_HAL_OSCCAL
+void hadUsbReset(void) {
+}
+#endif
+
+// gcc warns about the inline keyword of usbBuildTxBlock(), but keeps it out of line.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wattributes"
+static inline void usbBuildTxBlock(void) __attribute__((noinline));
+static uchar usbDeviceRead(uchar *data, uchar len) __attribute__((noinline));
+static void usbGenericSetInterrupt(uchar *data, uchar len, usbTxStatus_t *txStatus) __attribute__((noinline));
+
+#include "usbdrv.c"
+#pragma GCC diagnostic pop
+
+// Defines a benchmark case, which must call BENCH_START() and BENCH_STOP() once.
+#define BENCH_CASE(name)        static void __attribute__((noinline)) name(void)
+// The barriers keep the compiler from moving memory accesses across the markers.
+#define BENCH_START()           do { __asm__ __volatile__("" ::: "memory"); BENCH_RUNNING = 1; } while(0)
+#define BENCH_STOP()            do { BENCH_RUNNING = 0; __asm__ __volatile__("" ::: "memory"); } while(0)
+
+// Set while a case runs, watched by the runner.
+volatile uchar BENCH_RUNNING;
+
+PROGMEM const char usbDescriptorHidReport[] = OG_REPORT_DESCRIPTOR;
+
+// One full packet of data, with room for the CRC.
+static uchar RAM_DATA[10] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+static PROGMEM const uchar FLASH_DATA[8] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+static uchar BUF[8];
+// GET_DESCRIPTOR of the device descriptor, the first request of every enumeration.
+static const uchar SETUP[8] = { 0x80, USBRQ_GET_DESCRIPTOR, 0, USBDESCR_DEVICE, 0, 0, 18, 0 };
+// Settings read by the filter, set to their defaults in main(), and the frame it filters.
+tuning_t TUNING;
+calibration_t CALIB;
+static frame_t FRAME;
+
+usbMsgLen_t usbFunctionSetup(uchar data[8]) {
+    return 0;
+}
+
+uchar usbFunctionRead(uchar *data, uchar len) {
+    return len;
+}
+
+uchar usbFunctionWrite(uchar *data, uchar len) {
+    return 1;
+}
+
+// Queues a message of 8 bytes and frees the transmit buffer, so the next usbPoll() builds a packet.
+static void benchMessage(const void *data, uchar flags) {
+    usbMsgPtr = (usbMsgPtr_t) data;
+    usbMsgFlags = flags;
+    usbMsgLen = 8;
+    usbTxLen = USBPID_NAK;
+}
+
+BENCH_CASE(benchMarkers) {
+    BENCH_START();
+    BENCH_STOP();
+}
+
+BENCH_CASE(benchCrc16) {
+    BENCH_START();
+    usbCrc16(RAM_DATA, 8);
+    BENCH_STOP();
+}
+
+BENCH_CASE(benchCrc16Append) {
+    BENCH_START();
+    usbCrc16Append(RAM_DATA, 8);
+    BENCH_STOP();
+}
+
+BENCH_CASE(benchSetInterrupt) {
+    usbTxLen1 = USBPID_NAK;
+    BENCH_START();
+    usbGenericSetInterrupt(RAM_DATA, 8, &usbTxStatus1);
+    BENCH_STOP();
+}
+
+BENCH_CASE(benchReadRam) {
+    benchMessage(RAM_DATA, 0);
+    BENCH_START();
+    usbDeviceRead(BUF, 8);
+    BENCH_STOP();
+}
+
+BENCH_CASE(benchReadFlash) {
+    benchMessage(FLASH_DATA, USB_FLG_MSGPTR_IS_ROM);
+    BENCH_START();
+    usbDeviceRead(BUF, 8);
+    BENCH_STOP();
+}
+
+BENCH_CASE(benchBuildTxRam) {
+    benchMessage(RAM_DATA, 0);
+    BENCH_START();
+    usbBuildTxBlock();
+    BENCH_STOP();
+}
+
+BENCH_CASE(benchBuildTxFlash) {
+    benchMessage(FLASH_DATA, USB_FLG_MSGPTR_IS_ROM);
+    BENCH_START();
+    usbBuildTxBlock();
+    BENCH_STOP();
+}
+
+// Nothing received and nothing to send.
+BENCH_CASE(benchPollIdle) {
+    usbMsgLen = USB_NO_MSG;
+    usbTxLen = USBPID_NAK;
+    BENCH_START();
+    usbPoll();
+    BENCH_STOP();
+}
+
+// A received SETUP packet is answered and the first packet of the reply is built with its CRC.
+BENCH_CASE(benchPollSetup) {
+    memcpy(usbRxBuf + USB_BUFSIZE + 1, SETUP, sizeof(SETUP));
+    usbInputBufOffset = 0;
+    usbRxToken = USBPID_SETUP;
+    usbRxLen = sizeof(SETUP) + 3;
+    BENCH_START();
+    usbPoll();
+    BENCH_STOP();
+}
+
+// Every axis rests on its center, the filtered values equal the raw ones.
+BENCH_CASE(benchFilterRest) {
+    for(uchar i = 0; i < OG_AXES; i++) FRAME.axes[i] = CALIB.center[i];
+    for(uchar i = 0; i < 64; i++) filterUpdate(&FRAME);
+    BENCH_START();
+    filterUpdate(&FRAME);
+    BENCH_STOP();
+}
+
+// Every axis jumps from its center to the end of its travel, each one leaves its band.
+BENCH_CASE(benchFilterMove) {
+    for(uchar i = 0; i < OG_AXES; i++) FRAME.axes[i] = 0xFF;
+    BENCH_START();
+    filterUpdate(&FRAME);
+    BENCH_STOP();
+}
+
+int main(void) {
+    // Drives D- high, which reads as the idle J state of a low speed bus, so usbPoll() sees no reset.
+    USBOUT |= 1 << USBMINUS;
+    USBDDR |= 1 << USBMINUS;
+
+    benchMarkers();
+    benchCrc16();
+    benchCrc16Append();
+    benchSetInterrupt();
+    benchReadRam();
+    benchReadFlash();
+    benchBuildTxRam();
+    benchBuildTxFlash();
+    benchPollIdle();
+    benchPollSetup();
+
+    for(uchar i = 0; i < OG_AXES; i++) {
+        CALIB.center[i] = 128;
+        TUNING.filterRest[i] = OG_FILTER_REST;
+        TUNING.filterSpeed[i] = OG_FILTER_SPEED;
+        TUNING.filterBand[i] = OG_FILTER_BAND;
+    }
+    benchFilterRest();
+    benchFilterMove();
+
+    // Sleeping with interrupts off ends the simulation.
+    cli();
+    sleep_enable();
+    for(;;) sleep_cpu();
+}
@@ -0,0 +1,138 @@
+/*
+ *  Driver benchmark runner for 'Open Game Pad' built on simavr.
+ *
+ *  Usage: ogbench [-m mcu] [-f hz] [-n name] bench.sym bench.elf
+ *
+ *  Runs the benchmark firmware (see bench.c) until it sleeps with interrupts off and prints one line per case:
+ *  'name case cycles', where 'name' tells the driver configurations apart (default: default). A case runs from the
+ *  moment BENCH_RUNNING is set to the moment it is cleared, and is named after the function which set it. The cycles of
+ *  the first case, which holds only the markers, are taken off the others and it is not printed.
+ *
+ *  avr-gcc does not store the part in the ELF file, -m and -f give it (default: attiny85 at 16.5 MHz).
+ * */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sim_avr.h>
+#include <sim_elf.h>
+
+#define BENCH_MCU           "attiny85"
+#define BENCH_FREQUENCY     16500000
+// The whole suite takes a few thousand cycles, anything longer hangs.
+#define BENCH_LIMIT_MS      100
+#define BENCH_FUNCS         1024
+
+typedef struct {
+    unsigned long addr;
+    char name[64];
+} func_t;
+
+static func_t FUNCS[BENCH_FUNCS];
+static unsigned FUNC_COUNT;
+// Data address of BENCH_RUNNING.
+static long RUNNING = -1;
+
+static int funcCompare(const void *a, const void *b) {
+    const func_t *x = a, *y = b;
+
+    return x->addr < y->addr ? -1 : x->addr > y->addr;
+}
+
+// Loads the code symbols and the address of BENCH_RUNNING from avr-nm output. Returns 0 on success.
+static int symbolsLoad(const char *path) {
+    char line[256], type;
+    FILE *f = fopen(path, "r");
+
+    if(!f) {
+        perror(path);
+        return -1;
+    }
+    while(FUNC_COUNT < BENCH_FUNCS && fgets(line, sizeof(line), f)) {
+        func_t *fn = &FUNCS[FUNC_COUNT];
+        if(sscanf(line, "%lx %c %63s", &fn->addr, &type, fn->name) != 3) continue;
+        // Data symbols live at 0x800000 and above in avr-nm output.
+        if(!strcmp(fn->name, "BENCH_RUNNING")) RUNNING = fn->addr & 0xFFFF;
+        if(fn->addr < 0x800000 && strchr("tTwW", type)) FUNC_COUNT++;
+    }
+    fclose(f);
+    if(!FUNC_COUNT || RUNNING < 0) {
+        fprintf(stderr, "%s: no code symbols or no BENCH_RUNNING\n", path);
+        return -1;
+    }
+    qsort(FUNCS, FUNC_COUNT, sizeof(func_t), funcCompare);
+
+    return 0;
+}
+
+// Returns the name of the function the byte address belongs to.
+static const char *funcName(unsigned long pc) {
+    unsigned lo = 0, hi = FUNC_COUNT;
+
+    if(pc < FUNCS[0].addr) return "[unknown]";
+    while(hi - lo > 1) {
+        unsigned mid = (lo + hi) / 2;
+        if(FUNCS[mid].addr <= pc) lo = mid;
+        else hi = mid;
+    }
+
+    return FUNCS[lo].name;
+}
+
+int main(int argc, char **argv) {
+    const char *mcu = BENCH_MCU, *config = "default", *name = NULL;
+    uint32_t frequency = BENCH_FREQUENCY;
+    avr_cycle_count_t start = 0, cycles, markers = 0, limit;
+    elf_firmware_t fw;
+    avr_t *avr;
+    int opt, state = cpu_Running, cases = 0;
+    uint8_t running = 0;
+
+    memset(&fw, 0, sizeof(fw));
+    while((opt = getopt(argc, argv, "m:f:n:")) != -1) {
+        if(opt == 'm') mcu = optarg;
+        if(opt == 'f') frequency = strtoul(optarg, NULL, 10);
+        if(opt == 'n') config = optarg;
+    }
+    if(optind != argc - 2) {
+        fprintf(stderr, "usage: %s [-m mcu] [-f hz] [-n name] bench.sym bench.elf\n", argv[0]);
+        return 2;
+    }
+    if(symbolsLoad(argv[optind])) return 1;
+    if(elf_read_firmware(argv[optind + 1], &fw)) {
+        fprintf(stderr, "%s: cannot read the firmware\n", argv[optind + 1]);
+        return 1;
+    }
+    if(!fw.mmcu[0]) snprintf(fw.mmcu, sizeof(fw.mmcu), "%s", mcu);
+    if(!fw.frequency) fw.frequency = frequency;
+    if(!(avr = avr_make_mcu_by_name(fw.mmcu))) {
+        fprintf(stderr, "%s: unsupported part\n", fw.mmcu);
+        return 1;
+    }
+    avr_init(avr);
+    avr->frequency = fw.frequency;
+    avr_load_firmware(avr, &fw);
+
+    limit = (avr_cycle_count_t) BENCH_LIMIT_MS * avr->frequency / 1000;
+    while(avr->cycle < limit && state != cpu_Done && state != cpu_Crashed) {
+        unsigned long pc = avr->pc;
+        state = avr_run(avr);
+        if(avr->data[RUNNING] == running) continue;
+        running = avr->data[RUNNING];
+        if(running) {
+            name = funcName(pc);
+            start = avr->cycle;
+            continue;
+        }
+        cycles = avr->cycle - start;
+        if(!cases++) markers = cycles;
+        else printf("%s %s %llu\n", config, name, (unsigned long long) (cycles - markers));
+    }
+
+    if(state != cpu_Done || running || cases < 2) {
+        fprintf(stderr, "%s: the benchmark did not finish\n", argv[optind + 1]);
+        return 1;
+    }
+    return 0;
+}
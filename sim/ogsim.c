@@ -0,0 +1,286 @@
+/*
+ *  Simulation runner for 'Open Game Pad' built on simavr.
+ *
+ *  Usage: ogsim [-m mcu] [-f hz] [-b boot.elf] [-s main.sym [-p main.folded]] main.elf
+ *
+ *  The flash is laid out the way the bootloader leaves it after an upload: the firmware with its reset vector pointing
+ *  to the bootloader and the trampoline right below the bootloader. The runner then checks the start-up paths:
+ *
+ *  - a plain reset starts the firmware right away,
+ *  - the magic left by OG_RQ_BOOTLOADER keeps the bootloader running until its idle timeout starts the firmware,
+ *  - a pad without a complete firmware stays in the bootloader.
+ *
+ *  USB traffic is not simulated, so the page programming itself is only covered on real hardware.
+ *
+ *  With -s (the output of avr-nm for main.elf) the firmware runs alone on a bus that only sends keep-alives, and the
+ *  runner measures the share of cycles the CPU sleeps and the longest awake stretch between two calls of usbPoll(). The
+ *  latter bounds how late a received packet is handled, so it must not grow when idle sleep is enabled. The runner also
+ *  counts the free RAM the stack never reached (see src/stack.h). Only the idle paths run, so vendor requests and key
+ *  presses can still take more.
+ *
+ *  With -p the idle run is profiled from the reset on, every instruction is attributed to its function (see profile.h).
+ *  The cycles of the measured second are printed per function and written as folded stacks to the given file. The
+ *  simulation runs several times slower while profiling.
+ *
+ *  avr-gcc does not store the part in the ELF file, -m and -f give it (default: attiny85 at 16.5 MHz). The bootloader
+ *  checks only apply to the ATtiny85, see src/hal.h.
+ * */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sim_avr.h>
+#include <sim_elf.h>
+#include <sim_io.h>
+#include <sim_cycle_timers.h>
+#include <avr_ioport.h>
+
+#include "../boot/bootloader.h"
+#include "../src/stack.h"
+#include "profile.h"
+
+#define SIM_MCU             "attiny85"
+#define SIM_FREQUENCY       16500000
+// Time the firmware needs to connect to the bus and the length of the idle measurement, in milliseconds.
+#define SIM_STARTUP_MS      500
+#define SIM_IDLE_MS         1000
+
+// D- line of each supported part, the same as in its backend in src/hal.h.
+static const struct {
+    const char *mcu;
+    char port;
+    int dminus;
+} PARTS[] = {
+    {"attiny85", 'B', 1},
+    {"atmega328p", 'D', 4},
+};
+
+static const char *MCU = SIM_MCU;
+// Folded stack file of the profile, NULL while not profiling.
+static const char *PROFILE;
+static uint32_t FREQUENCY = SIM_FREQUENCY;
+static elf_firmware_t APP, BOOT;
+// Byte addresses of the bootloader and of the firmware entry the trampoline jumps to.
+static uint32_t BOOT_ADDR, APP_ENTRY;
+
+// Reads an ELF file, filling the MCU details which avr-gcc does not store.
+static int firmwareRead(const char *path, elf_firmware_t *fw) {
+    if(elf_read_firmware(path, fw)) {
+        fprintf(stderr, "%s: cannot read the firmware\n", path);
+        return -1;
+    }
+    if(!fw->mmcu[0]) snprintf(fw->mmcu, sizeof(fw->mmcu), "%s", MCU);
+    if(!fw->frequency) fw->frequency = FREQUENCY;
+
+    return 0;
+}
+
+// Creates a fresh MCU with the bootloader and, if requested, an installed firmware.
+static avr_t *mcuCreate(int withApp, int magic) {
+    avr_t *avr = avr_make_mcu_by_name(BOOT.mmcu);
+    uint16_t reset;
+
+    avr_init(avr);
+    avr->frequency = BOOT.frequency;
+    avr_load_firmware(avr, &BOOT);
+
+    if(withApp) {
+        memcpy(avr->flash, APP.flash, APP.flashsize);
+        // What the bootloader does to every image it receives.
+        reset = avr->flash[0] | avr->flash[1] << 8;
+        APP_ENTRY = BOOT_RJMP_TARGET(0, reset);
+        reset = BOOT_RJMP(BOOT_ADDR - 2, APP_ENTRY);
+        avr->flash[BOOT_ADDR - 2] = reset;
+        avr->flash[BOOT_ADDR - 1] = reset >> 8;
+    }
+    // Page 0 always jumps to the bootloader, a blank pad gets it from boot.hex.
+    reset = BOOT_RJMP(0, BOOT_ADDR);
+    avr->flash[0] = reset;
+    avr->flash[1] = reset >> 8;
+
+    if(magic) {
+        avr->data[BOOT_MAGIC_ADDR] = BOOT_MAGIC & 0xFF;
+        avr->data[BOOT_MAGIC_ADDR + 1] = BOOT_MAGIC >> 8;
+    }
+    avr->pc = 0;
+
+    return avr;
+}
+
+// Runs the MCU until the firmware entry is reached or 'ms' milliseconds pass. Returns the time of the entry, -1 if none.
+static double mcuRun(avr_t *avr, double ms) {
+    avr_cycle_count_t limit = avr->cycle + (avr_cycle_count_t) (ms * avr->frequency / 1000);
+    int state = cpu_Running;
+
+    while(avr->cycle < limit && state != cpu_Done && state != cpu_Crashed) {
+        if(APP_ENTRY && avr->pc == APP_ENTRY) return avr->cycle * 1000.0 / avr->frequency;
+        state = avr_run(avr);
+    }
+
+    return -1;
+}
+
+// Prints the result of a single check. Returns 1 if it failed.
+static int report(const char *name, int ok, double ms) {
+    printf("%-40s %s", name, ok ? "ok" : "FAILED");
+    if(ms >= 0) printf(" (firmware entered after %.3f ms)", ms);
+    printf("\n");
+
+    return !ok;
+}
+
+// Looks up a symbol in avr-nm output. Returns its address or -1.
+static long symbolFind(const char *path, const char *name) {
+    char line[256], sym[200], type;
+    unsigned long addr;
+    FILE *f = fopen(path, "r");
+    long found = -1;
+
+    if(!f) {
+        perror(path);
+        return -1;
+    }
+    while(found < 0 && fgets(line, sizeof(line), f)) {
+        if(sscanf(line, "%lx %c %199s", &addr, &type, sym) == 3 && !strcmp(sym, name)) found = addr;
+    }
+    fclose(f);
+
+    return found;
+}
+
+// Runs one step of the MCU, through the profiler if it is on. Its cycles only count while 'count' is set.
+static int simRun(avr_t *avr, int count) {
+    return PROFILE ? profileRun(avr, count) : avr_run(avr);
+}
+
+// Sends a keep-alive on D- every millisecond: a short SE0, which only pulls D- low on a low speed bus.
+static avr_cycle_count_t keepAlive(avr_t *avr, avr_cycle_count_t when, void *param) {
+    avr_raise_irq((avr_irq_t *) param, 0);
+    avr_raise_irq((avr_irq_t *) param, 1);
+
+    return when + avr->frequency / 1000;
+}
+
+/*
+ * Runs the firmware on an idle bus. Returns 1 if it failed.
+ *
+ * The CPU must stay awake (not suspend) while keep-alives arrive, and it reports how much of the time it sleeps.
+ * */
+static int idleMeasure(const char *symbols) {
+    avr_cycle_count_t start, awake = 0, worst = 0, slept = 0, cycle, last, gap = 0;
+    long poll = symbolFind(symbols, "usbPoll"), heap = symbolFind(symbols, "__heap_start");
+    avr_t *avr = avr_make_mcu_by_name(APP.mmcu);
+    avr_irq_t *dminus;
+    unsigned part = 0, left;
+    int state;
+
+    while(part < sizeof(PARTS) / sizeof(PARTS[0]) && strcmp(PARTS[part].mcu, APP.mmcu)) part++;
+    if(part == sizeof(PARTS) / sizeof(PARTS[0]) || !avr) {
+        fprintf(stderr, "%s: unsupported part\n", APP.mmcu);
+        return 1;
+    }
+    if(poll < 0 || heap < 0) {
+        fprintf(stderr, "%s: usbPoll or __heap_start not found\n", symbols);
+        return 1;
+    }
+    avr_init(avr);
+    avr->frequency = APP.frequency;
+    avr_load_firmware(avr, &APP);
+    dminus = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(PARTS[part].port), PARTS[part].dminus);
+    avr_raise_irq(dminus, 1);                       // J state, held by the pull-up on D-.
+    avr_cycle_timer_register_usec(avr, 1000, keepAlive, dminus);
+
+    // The start-up is stepped the same way, so the profiler follows the stack from the reset on.
+    start = avr->cycle + (avr_cycle_count_t) SIM_STARTUP_MS * avr->frequency / 1000;
+    do {
+        state = simRun(avr, 0);
+    } while(avr->cycle < start && state != cpu_Done && state != cpu_Crashed);
+    start = last = avr->cycle;
+    while(avr->cycle - start < (avr_cycle_count_t) SIM_IDLE_MS * avr->frequency / 1000) {
+        cycle = avr->cycle;
+        if(avr->state == cpu_Sleeping) {
+            simRun(avr, 1);
+            slept += avr->cycle - cycle;
+            continue;
+        }
+        if(avr->pc == poll) {
+            if(awake > worst) worst = awake;
+            if(cycle - last > gap) gap = cycle - last;
+            awake = 0;
+            last = cycle;
+        }
+        state = simRun(avr, 1);
+        awake += avr->cycle - cycle;
+        if(state == cpu_Done || state == cpu_Crashed) break;
+    }
+
+    printf("%-40s %.1f %% of %d ms\n", "idle bus: CPU asleep", 100.0 * slept / (avr->cycle - start), SIM_IDLE_MS);
+    printf("%-40s %llu cycles (%.1f us)\n", "idle bus: longest awake usbPoll() gap", (unsigned long long) worst,
+        worst * 1e6 / avr->frequency);
+
+    // The clock tick wakes the loop every millisecond, unless the pad took the keep-alives for a suspend.
+    if(avr->cycle - last > gap) gap = avr->cycle - last;
+    // Data addresses carry an offset of 0x800000 in avr-nm output.
+    heap &= 0xFFFF;
+    for(left = 0; heap + left <= avr->ramend && avr->data[heap + left] == OG_STACK_CANARY; left++);
+    printf("%-40s %u bytes\n", "idle bus: least free stack", left);
+
+    if(PROFILE && profileWrite(PROFILE)) return 1;
+    return report("stack stays clear of .bss", left > 0, -1) +
+        report("idle bus keeps the pad awake", avr->state != cpu_Crashed && gap < avr->frequency / 500, -1);
+}
+
+int main(int argc, char **argv) {
+    const char *boot = NULL, *symbols = NULL;
+    int opt, failed = 0;
+    double ms;
+    avr_t *avr;
+
+    while((opt = getopt(argc, argv, "m:f:b:s:p:")) != -1) {
+        if(opt == 'm') MCU = optarg;
+        if(opt == 'f') FREQUENCY = strtoul(optarg, NULL, 10);
+        if(opt == 'b') boot = optarg;
+        if(opt == 's') symbols = optarg;
+        if(opt == 'p') PROFILE = optarg;
+    }
+    if((!boot && !symbols) || (PROFILE && !symbols) || optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-m mcu] [-f hz] [-b boot.elf] [-s main.sym [-p main.folded]] main.elf\n", argv[0]);
+        return 2;
+    }
+    if(PROFILE && profileLoad(symbols)) return 1;
+    if(firmwareRead(argv[optind], &APP)) return 1;
+    if(symbols) failed += idleMeasure(symbols);
+    if(!boot) return failed != 0;
+    if(firmwareRead(boot, &BOOT)) return 1;
+
+    BOOT_ADDR = BOOT.flashbase;
+    if(!BOOT_ADDR || BOOT_ADDR % BOOT_PAGE_SIZE) {
+        fprintf(stderr, "%s: bootloader is not linked to a page boundary\n", boot);
+        return 1;
+    }
+    if(APP.flashsize > BOOT_ADDR - 2) {
+        fprintf(stderr, "firmware of %u bytes overlaps the bootloader at 0x%04x\n", APP.flashsize, BOOT_ADDR);
+        return 1;
+    }
+
+    // The bootloader must not delay a normal start.
+    avr = mcuCreate(1, 0);
+    ms = mcuRun(avr, 10);
+    failed += report("plain reset starts the firmware", ms >= 0 && ms < 1, ms);
+
+    // The magic keeps the bootloader until it times out without a host.
+    avr = mcuCreate(1, 1);
+    ms = mcuRun(avr, 1000);
+    failed += report("magic keeps the bootloader", ms < 0 && avr->pc >= BOOT_ADDR, -1);
+    ms = mcuRun(avr, 10000);
+    failed += report("idle bootloader starts the firmware", ms >= 0, ms);
+
+    // Without a trampoline there is nothing to start.
+    APP_ENTRY = 0;
+    avr = mcuCreate(0, 0);
+    mcuRun(avr, 1000);
+    failed += report("blank pad stays in the bootloader", avr->pc >= BOOT_ADDR, -1);
+
+    return failed != 0;
+}
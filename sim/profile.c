@@ -0,0 +1,270 @@
+/*
+ *  Cycle profiler of the simulation runner, see profile.h.
+ * */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sim_avr.h>
+
+#include "profile.h"
+
+// Limits of the symbol table, of the distinct call stacks and of the stack depth.
+#define PROFILE_FUNCS       1024
+#define PROFILE_NODES       16384
+#define PROFILE_DEPTH       64
+// Size of the hash of the call stack nodes, a power of two well above PROFILE_NODES.
+#define PROFILE_HASH        65536
+
+typedef struct {
+    unsigned long addr;
+    char name[64];
+    unsigned long long self;                    // Cycles spent in the function itself.
+    unsigned long long total;                   // Cycles spent in the function and everything it called.
+    unsigned long calls;
+    unsigned long mark;                         // Last step which counted the function as inclusive.
+    unsigned long irqs;                         // Interrupts handled by the function, and their cycles from the entry
+    unsigned long long irqCycles, irqLongest;   // to the return, nested interrupts included: in total and the longest.
+} func_t;
+
+// One distinct call stack: the stack of 'parent' with 'func' called on top of it.
+typedef struct {
+    int parent;
+    unsigned func;
+    unsigned long long cycles;
+} node_t;
+
+// Functions sorted by address, followed by the pseudo functions.
+static func_t FUNCS[PROFILE_FUNCS + 2];
+static unsigned FUNC_COUNT, VECTORS, UNKNOWN, SLEEP;
+static node_t NODES[PROFILE_NODES];
+static unsigned NODE_COUNT;
+static int HASH[PROFILE_HASH];
+// Followed call stack, each frame with the stack pointer right after its entry. Interrupt frames keep the cycle of the
+// entry, the others 0.
+static struct {
+    int node;
+    unsigned sp;
+    avr_cycle_count_t irq;
+} STACK[PROFILE_DEPTH];
+// Clock of the MCU, for the interrupt times.
+static unsigned long FREQUENCY;
+static unsigned DEPTH;
+static unsigned long STEP;
+
+static int funcCompare(const void *a, const void *b) {
+    const func_t *x = a, *y = b;
+
+    return x->addr < y->addr ? -1 : x->addr > y->addr;
+}
+
+int profileLoad(const char *symbols) {
+    char line[256], type;
+    unsigned i, n = 0;
+    FILE *f = fopen(symbols, "r");
+
+    if(!f) {
+        perror(symbols);
+        return -1;
+    }
+    while(fgets(line, sizeof(line), f)) {
+        func_t *fn = &FUNCS[FUNC_COUNT];
+        // Only code symbols, data symbols live at 0x800000 and above in avr-nm output.
+        if(sscanf(line, "%lx %c %63s", &fn->addr, &type, fn->name) != 3 || !strchr("tTwW", type)) continue;
+        if(fn->addr >= 0x800000) continue;
+        if(++FUNC_COUNT == PROFILE_FUNCS) break;
+    }
+    fclose(f);
+    if(!FUNC_COUNT) {
+        fprintf(stderr, "%s: no code symbols\n", symbols);
+        return -1;
+    }
+
+    // Aliases of the same address are merged, the first name is kept.
+    qsort(FUNCS, FUNC_COUNT, sizeof(func_t), funcCompare);
+    for(i = 0; i < FUNC_COUNT; i++) {
+        if(n && FUNCS[n - 1].addr == FUNCS[i].addr) continue;
+        FUNCS[n++] = FUNCS[i];
+    }
+    FUNC_COUNT = n;
+    for(VECTORS = 0; VECTORS < FUNC_COUNT && strcmp(FUNCS[VECTORS].name, "__vectors"); VECTORS++);
+    UNKNOWN = FUNC_COUNT;
+    SLEEP = FUNC_COUNT + 1;
+    strcpy(FUNCS[UNKNOWN].name, "[unknown]");
+    strcpy(FUNCS[SLEEP].name, "[sleep]");
+    memset(HASH, -1, sizeof(HASH));
+
+    return 0;
+}
+
+// Returns the function the byte address belongs to.
+static unsigned funcFind(unsigned long pc) {
+    unsigned lo = 0, hi = FUNC_COUNT;
+
+    if(pc < FUNCS[0].addr) return UNKNOWN;
+    while(hi - lo > 1) {
+        unsigned mid = (lo + hi) / 2;
+        if(FUNCS[mid].addr <= pc) lo = mid;
+        else hi = mid;
+    }
+
+    return lo;
+}
+
+// Returns the node of 'func' called on top of the stack 'parent' (-1 for the bottom), creating it if needed.
+static int nodeFind(int parent, unsigned func) {
+    unsigned h = ((unsigned) parent * 2654435761u + func) & (PROFILE_HASH - 1);
+
+    for(; HASH[h] >= 0; h = (h + 1) & (PROFILE_HASH - 1)) {
+        if(NODES[HASH[h]].parent == parent && NODES[HASH[h]].func == func) return HASH[h];
+    }
+    // A full table keeps adding to the parent, so the cycles are still counted.
+    if(NODE_COUNT == PROFILE_NODES) return parent < 0 ? 0 : parent;
+    NODES[NODE_COUNT].parent = parent;
+    NODES[NODE_COUNT].func = func;
+    HASH[h] = NODE_COUNT;
+
+    return NODE_COUNT++;
+}
+
+// Adds the cycles of one step to its function, to every function on the stack and to the stack itself.
+static void profileCount(unsigned func, unsigned long long cycles) {
+    int node = STACK[DEPTH - 1].node;
+
+    if(NODES[node].func != func) node = nodeFind(node, func);
+    NODES[node].cycles += cycles;
+    FUNCS[func].self += cycles;
+    STEP++;
+    for(; node >= 0; node = NODES[node].parent) {
+        func_t *fn = &FUNCS[NODES[node].func];
+        if(fn->mark == STEP) continue;          // Recursion counts once.
+        fn->mark = STEP;
+        fn->total += cycles;
+    }
+}
+
+static unsigned spGet(avr_t *avr) {
+    return avr->data[R_SPL] | avr->data[R_SPH] << 8;
+}
+
+// Pushes a frame of 'func' entered with the stack pointer 'sp', at cycle 'irq' for an interrupt and 0 otherwise.
+static void frameCall(unsigned func, unsigned sp, avr_cycle_count_t irq, int count) {
+    if(DEPTH < PROFILE_DEPTH) {
+        STACK[DEPTH].node = nodeFind(STACK[DEPTH - 1].node, func);
+        STACK[DEPTH].sp = sp;
+        STACK[DEPTH].irq = irq;
+        DEPTH++;
+    }
+    if(count) FUNCS[func].calls++;
+}
+
+// Pops the top frame at 'cycle'. An interrupt window is counted to the handler the vector jumped to.
+static void frameReturn(avr_cycle_count_t cycle, int count) {
+    DEPTH--;
+    if(STACK[DEPTH].irq && count) {
+        func_t *fn = &FUNCS[NODES[STACK[DEPTH].node].func];
+        avr_cycle_count_t cycles = cycle - STACK[DEPTH].irq;
+        fn->irqs++;
+        fn->irqCycles += cycles;
+        if(cycles > fn->irqLongest) fn->irqLongest = cycles;
+    }
+}
+
+int profileRun(avr_t *avr, int count) {
+    unsigned long pc = avr->pc;
+    unsigned before = spGet(avr), from = funcFind(pc), func, sp;
+    avr_cycle_count_t cycle = avr->cycle;
+    int sleeping = avr->state == cpu_Sleeping;
+    int state = avr_run(avr);
+
+    if(!DEPTH) {
+        STACK[0].node = nodeFind(-1, from);
+        STACK[0].sp = before;
+        DEPTH = 1;
+        FREQUENCY = avr->frequency;
+    }
+    if(count) profileCount(sleeping ? SLEEP : from, avr->cycle - cycle);
+
+    // Returns first, an interrupt taken right after a return then lands on the caller.
+    sp = spGet(avr);
+    while(DEPTH > 1 && sp > STACK[DEPTH - 1].sp) frameReturn(avr->cycle, count);
+    func = funcFind(avr->pc);
+    if(func == VECTORS && from != VECTORS) {
+        frameCall(func, sp, cycle, count);              // Interrupt entry, the window starts with the taken step.
+        return state;
+    }
+    // Running into the next symbol and 'rcall .', which gcc uses to reserve stack, are no calls.
+    if(func == UNKNOWN || FUNCS[func].addr != avr->pc || avr->pc == pc + 2 || avr->pc == pc + 4) return state;
+    if(func == NODES[STACK[DEPTH - 1].node].func) return state;
+    if(sp < before) {
+        frameCall(func, sp, 0, count);
+    }else if(from == VECTORS) {
+        // The jump of the vector table to the handler, or of the reset to the start-up code.
+        STACK[DEPTH - 1].node = nodeFind(NODES[STACK[DEPTH - 1].node].parent, func);
+        if(count) FUNCS[func].calls++;
+    }
+    // Other jumps to a symbol stay in the frame, e.g. between the labels of the V-USB interrupt. Their cycles are still
+    // counted to the symbol they run in.
+
+    return state;
+}
+
+static int selfCompare(const void *a, const void *b) {
+    const func_t *x = *(const func_t **) a, *y = *(const func_t **) b;
+
+    return x->self > y->self ? -1 : x->self < y->self;
+}
+
+// Writes the stack of the node, bottom first.
+static void nodePrint(FILE *f, int node) {
+    if(NODES[node].parent >= 0) {
+        nodePrint(f, NODES[node].parent);
+        fputc(';', f);
+    }
+    fputs(FUNCS[NODES[node].func].name, f);
+}
+
+int profileWrite(const char *path) {
+    static func_t *order[PROFILE_FUNCS + 2];
+    unsigned long long all = 0;
+    unsigned i, n = FUNC_COUNT + 2;
+    FILE *f;
+
+    for(i = 0; i < n; i++) {
+        order[i] = &FUNCS[i];
+        all += FUNCS[i].self;
+    }
+    if(!all) all = 1;
+    qsort(order, n, sizeof(order[0]), selfCompare);
+    printf("%-32s %12s %7s %12s %7s %9s\n", "function", "self", "%", "total", "%", "calls");
+    for(i = 0; i < n; i++) {
+        if(!order[i]->total) continue;
+        printf("%-32s %12llu %6.2f%% %12llu %6.2f%% %9lu\n", order[i]->name, order[i]->self, 100.0 * order[i]->self / all,
+            order[i]->total, 100.0 * order[i]->total / all, order[i]->calls);
+    }
+    if(NODE_COUNT == PROFILE_NODES) fprintf(stderr, "profile: too many call stacks, the deepest ones are merged\n");
+
+    printf("\n%-32s %9s %12s %9s %9s %9s\n", "interrupt", "entries", "cycles", "mean", "longest", "us");
+    for(i = 0; i < n; i++) {
+        const func_t *fn = &FUNCS[i];
+        // Handlers are listed even without an entry, so an interrupt that never fired stands out.
+        if(!fn->irqs && (strncmp(fn->name, "__vector_", 9) || !isdigit((unsigned char) fn->name[9]))) continue;
+        printf("%-32s %9lu %12llu %9llu %9llu %9.1f\n", fn->name, fn->irqs, fn->irqCycles,
+            fn->irqs ? fn->irqCycles / fn->irqs : 0, fn->irqLongest, FREQUENCY ? 1e6 * fn->irqLongest / FREQUENCY : 0);
+    }
+
+    if(!(f = fopen(path, "w"))) {
+        perror(path);
+        return -1;
+    }
+    for(i = 0; i < NODE_COUNT; i++) {
+        if(!NODES[i].cycles) continue;
+        nodePrint(f, i);
+        fprintf(f, " %llu\n", NODES[i].cycles);
+    }
+    fclose(f);
+    printf("%-40s %s\n", "folded stacks written to", path);
+
+    return 0;
+}
@@ -0,0 +1,38 @@
+/*
+ *  Cycle profiler of the simulation runner.
+ *
+ *  Every instruction is attributed to the function its address belongs to, looked up in the avr-nm output of the
+ *  firmware. The call stack is followed from the stack pointer: a call or an interrupt lowers it and lands on the start of
+ *  a function or in the vector table, a return raises it above the level the callee started with. Jumps to the start of
+ *  another function only count as calls when they leave the vector table, other jumps stay in the frame of the caller.
+ *  Cycles spent asleep are counted as '[sleep]'. Interrupt handlers show under their vector names, on the ATtiny85
+ *  __vector_1 is V-USB (INT0), __vector_8 the scan (ADC) and __vector_4 the clock tick.
+ *
+ *  The result is a table of exclusive and inclusive cycles per function and a folded stack file for flamegraph.pl, one
+ *  line per distinct call stack: 'main;usbPoll;usbCrc16 1234'. A second table times every interrupt from its entry to
+ *  the return of its handler, nested interrupts included: entries, cycles in total, the mean and the longest window. The
+ *  longest V-USB window bounds how long the scan and the clock tick can be held off.
+ *
+ *  ogsim profiles the idle bus only, the host never sends a request and never collects a report. The runner holds the
+ *  J state and never toggles D+, so INT0 does not fire and the V-USB interrupt shows with no entries; its windows need
+ *  host traffic injected on D+/D-, which ogsim does not simulate yet. usbPoll(), the scan and the clock tick show their
+ *  real share, but usbBuildTxBlock() only runs for control transfers and never appears, and usbCrc16Append() runs once
+ *  for the first interrupt report. Their cost under load needs that traffic too, or the per call cycles of 'make bench'.
+ * */
+
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include <sim_avr.h>
+
+// Loads the function symbols from avr-nm output. Returns 0 on success.
+int profileLoad(const char *symbols);
+
+// Runs one instruction, or one sleep, of an MCU that is followed since its reset. Cycles are counted while 'count' is set.
+// Returns the state of avr_run().
+int profileRun(avr_t *avr, int count);
+
+// Prints the table and writes the folded stacks to 'path'. Returns 0 on success.
+int profileWrite(const char *path);
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ *  Joystick center tracking of 'Open Game Pad'.
+ * */
+
+#include "center.h"
+#include "filter.h"
+#include "settings.h"
+
+_Static_assert(OG_CENTER_SHIFT <= 14, "the center must settle closer than half a count to the resting reading");
+
+// Tracked centers in 8.16 fixed point, the upper 16 bits in CENTER and the lowest 8 in FRACTION, so even the smallest
+// drift still moves them by OG_CENTER_SHIFT. The centers last written to CALIB and the ones last saved to the EEPROM.
+static uint16_t CENTER[OG_AXES];
+static uint8_t FRACTION[OG_AXES];
+static uint8_t TRACKED[OG_AXES];
+static uint8_t SAVED[OG_AXES];
+// Keys of the previous call and milliseconds left until the pad counts as resting.
+static uint32_t KEYS;
+static uint16_t QUIET;
+// Time since the last save, in milliseconds and minutes.
+static uint16_t SAVE_MS;
+static uint8_t SAVE_MIN;
+
+// Distance of two readings.
+static uint8_t distance(uint8_t a, uint8_t b) {
+    return a > b ? a - b : b - a;
+}
+
+void centerInit(void) {
+    for(uint8_t i = 0; i < OG_AXES; i++) {
+        CENTER[i] = (uint16_t) CALIB.center[i] << 8;
+        FRACTION[i] = 0;
+        TRACKED[i] = SAVED[i] = CALIB.center[i];
+    }
+    QUIET = OG_CENTER_QUIET_MS;
+}
+
+/*
+ * Every axis takes the same steps on every call. A center written by the host through the configuration blob replaces
+ * the tracked one.
+ * */
+void centerUpdate(const frame_t *frame) {
+    frame_t filtered = *frame;
+    uint8_t moved = 0;
+
+    filterRead(&filtered);
+    if(frame->bmask != KEYS || frame->pressed) {
+        KEYS = frame->bmask;
+        QUIET = OG_CENTER_QUIET_MS;
+    }else if(QUIET) {
+        QUIET--;
+    }
+
+    for(uint8_t i = 0; i < OG_AXES; i++) {
+        uint32_t center = (uint32_t) CENTER[i] << 8 | FRACTION[i], target = (uint32_t) filtered.axes[i] << 16;
+
+        if(CALIB.center[i] != TRACKED[i]) {
+            center = (uint32_t) CALIB.center[i] << 16;
+            SAVED[i] = CALIB.center[i];
+        }else if(!QUIET && distance(frame->axes[i], filtered.axes[i]) <= OG_CENTER_NOISE
+                && distance(filtered.axes[i], CALIB.center[i]) <= OG_CENTER_RANGE) {
+            if(target > center) center += (target - center) >> OG_CENTER_SHIFT;
+            else center -= (center - target) >> OG_CENTER_SHIFT;
+        }
+        CENTER[i] = center >> 8;
+        FRACTION[i] = center;
+        TRACKED[i] = CALIB.center[i] = center >= 0xFF8000 ? 0xFF : (center + 0x8000) >> 16;
+        if(TRACKED[i] != SAVED[i]) moved = 1;
+    }
+
+    // The EEPROM only sees the center every few minutes, however often it moves.
+    if(++SAVE_MS >= 60000) {
+        SAVE_MS = 0;
+        if(SAVE_MIN < 0xFF) SAVE_MIN++;
+    }
+    if(moved && SAVE_MIN >= OG_CENTER_SAVE_MIN) {
+        for(uint8_t i = 0; i < OG_AXES; i++) SAVED[i] = TRACKED[i];
+        SAVE_MIN = 0;
+        eeJournalSave(OG_TAG_CALIB);
+    }
+}
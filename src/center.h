@@ -0,0 +1,23 @@
+/*
+ *  Joystick center tracking of 'Open Game Pad'.
+ *
+ *  While the pad rests, the rest value of every axis is followed slowly, so drift from temperature and wear does not creep
+ *  into the reports. An axis rests when no key changed for OG_CENTER_QUIET_MS, its raw reading stays within
+ *  OG_CENTER_NOISE of the filtered one and the filtered one is within OG_CENTER_RANGE of the current center. The center is
+ *  then moved by 2^-OG_CENTER_SHIFT of the distance each millisecond, kept in 8.8 fixed point. A moved center is used
+ *  right away, but written to the EEPROM at most once per OG_CENTER_SAVE_MIN minutes.
+ * */
+
+#ifndef __CENTER_H__
+#define __CENTER_H__
+
+#include <stdint.h>
+
+#include "ogpad.h"
+
+/* Starts tracking from the stored calibration. Must be called after settingsInit(). */
+void centerInit(void);
+/* Tracks the centers with the raw frame. Must be called once per millisecond, after filterUpdate(). */
+void centerUpdate(const frame_t *frame);
+
+#endif
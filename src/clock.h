@@ -0,0 +1,56 @@
+/*
+ *  System clock of 'Open Game Pad'.
+ *
+ *  The clock timer of the hardware backend (see hal.h) ticks about once per millisecond. On the ATtiny85 Timer1 runs from
+ *  CK/64 and overflows every 256 * 64 / 16.5 MHz = 0.993 ms. The tick interrupt only counts ticks, which also wakes the
+ *  main loop from idle sleep. The main loop turns the ticks into milliseconds. Short intervals are measured in timer
+ *  counts of OG_HAL_TIMER_PRESCALE CPU cycles (3.88 us on the ATtiny85), OG_HAL_TIMER_COUNTS of them make a tick.
+ * */
+
+#ifndef __CLOCK_H__
+#define __CLOCK_H__
+
+#include <stdint.h>
+
+#include "hal.h"
+
+// Timer1 overflows, counted by the interrupt.
+extern volatile uint8_t CLOCK_TICKS;
+// Milliseconds since power up, advanced by clockPoll().
+extern uint16_t CLOCK_MS;
+
+// Starts the clock timer and its tick interrupt.
+static inline void clockInit(void) {
+    halTimerInit();
+}
+
+// Returns non zero if CLOCK_MS is behind the interrupt.
+static inline uint8_t clockPending(void) {
+    return (uint8_t) CLOCK_MS != CLOCK_TICKS;
+}
+
+// Advances CLOCK_MS by one tick if the interrupt counted one. Returns 1 if a new millisecond started.
+static inline uint8_t clockPoll(void) {
+    if(!clockPending()) return 0;
+    CLOCK_MS++;
+    return 1;
+}
+
+// Current time in timer counts. Wraps after 254 ms on the ATtiny85, so only differences of short intervals are meaningful.
+static inline uint16_t clockNow(void) {
+    return CLOCK_MS * OG_HAL_TIMER_COUNTS + halTimerCount();
+}
+
+// Same as clockNow(), but built from the interrupt count, so it is exact in interrupts as well. Interrupts must be enabled.
+static inline uint16_t clockStamp(void) {
+    uint8_t ticks, count;
+
+    do {
+        ticks = CLOCK_TICKS;
+        count = halTimerCount();
+    } while(ticks != CLOCK_TICKS);
+
+    return ticks * OG_HAL_TIMER_COUNTS + count;
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ *  Wear-leveled EEPROM journal for 'Open Game Pad'.
+ *
+ *  Slot layout: [layout | tag][sequence][size][payload ... EE_PAYLOAD bytes][CRC-16 low][CRC-16 high]
+ *
+ *  The CRC covers everything before it. A record is only accepted when the CRC matches, so a write torn by a power loss
+ *  leaves the previous copy of the same record in charge. Writes always go to the next slot after the newest one that
+ *  does not hold the newest copy of some record, therefore every slot gets written about equally often.
+ *
+ *  The size is the one of the RAM image the copy was saved from. Only that many bytes are loaded, a record that grew since
+ *  keeps the defaults in its new fields and a record that shrank drops the extra bytes. The upper nibble of the tag byte
+ *  holds EE_LAYOUT, slots written with any other layout of the journal are ignored.
+ * */
+
+#include<avr/pgmspace.h>
+#include<avr/eeprom.h>
+#include<util/crc16.h>
+#include<string.h>
+
+#include "eejournal.h"
+#include "settings.h"
+
+_Static_assert(EE_SLOTS * OG_EE_SLOT_SIZE == OG_EE_SIZE, "journal slots must fill the EEPROM");
+_Static_assert((EE_SLOTS & (EE_SLOTS - 1)) == 0, "amount of journal slots must be a power of two");
+_Static_assert(OG_TAGS < EE_SLOTS && OG_TAGS <= 16, "too many journal records");
+_Static_assert(OG_EE_REFRESH_AGE + EE_SLOTS < 128, "journal refresh age overflows the sequence window");
+
+// EEPROM address of the byte 'off' inside the 'slot'.
+#define EE_ADDR(slot, off)  ((uint8_t *) ((uint16_t) (slot) * OG_EE_SLOT_SIZE + (off)))
+// Position of the CRC inside the slot.
+#define EE_CRC              (OG_EE_SLOT_SIZE - 2)
+// Journal layout kept in the upper nibble of the tag byte. Must change whenever the slot layout does.
+#define EE_LAYOUT           0x10
+// Bits of the tag byte holding the tag.
+#define EE_TAG_MASK         0x0F
+// Value of POS while no record is being written.
+#define EE_IDLE             0xFF
+
+// Slot that holds the newest valid copy of each record or EE_SLOTS if the record was never saved.
+static uint8_t SLOT_OF[OG_TAGS];
+// Sequence number of the newest copy of each record.
+static uint8_t SEQ_OF[OG_TAGS];
+// Newest sequence number and the slot where it was written.
+static uint8_t SEQ, HEAD = EE_SLOTS - 1;
+// Records waiting to be written, one bit per tag.
+static uint16_t DIRTY;
+// Image of the slot being written, its destination and the position of the next byte to program.
+static uint8_t SLOT[OG_EE_SLOT_SIZE];
+static uint8_t DST, POS = EE_IDLE;
+
+// Checks the CRC of the slot stored in the EEPROM.
+static uint8_t slotValid(uint8_t slot) {
+    uint16_t crc = 0xFFFF;
+    uint8_t i;
+
+    for(i = 0; i < EE_CRC; i++)
+        crc = _crc_ccitt_update(crc, eeprom_read_byte(EE_ADDR(slot, i)));
+
+    return crc == eeprom_read_word((const uint16_t *) EE_ADDR(slot, EE_CRC));
+}
+
+// Returns non zero if the slot holds the newest copy of some record and must not be overwritten.
+static uint8_t slotLive(uint8_t slot) {
+    uint8_t tag;
+
+    for(tag = 0; tag < OG_TAGS; tag++)
+        if(SLOT_OF[tag] == slot) return 1;
+
+    return 0;
+}
+
+// Reads the record description from the flash.
+static void recordGet(uint8_t tag, eeRecord *r) {
+    memcpy_P(r, &EE_RECORDS[tag], sizeof(eeRecord));
+}
+
+// Prepares the slot image for the lowest pending record and picks the slot it goes to.
+static void recordStage(void) {
+    uint16_t crc = 0xFFFF;
+    uint8_t tag = 0, i;
+    eeRecord r;
+
+    while(!(DIRTY & (1 << tag))) tag++;
+    DIRTY &= ~(1 << tag);
+    recordGet(tag, &r);
+
+    SLOT[0] = EE_LAYOUT | tag;
+    SLOT[1] = ++SEQ;
+    SLOT[2] = r.size;
+    memset(SLOT + 3, 0xFF, EE_PAYLOAD);
+    memcpy(SLOT + 3, r.data, r.size);
+    for(i = 0; i < EE_CRC; i++)
+        crc = _crc_ccitt_update(crc, SLOT[i]);
+    SLOT[EE_CRC] = crc;
+    SLOT[EE_CRC + 1] = crc >> 8;
+
+    // The next slot after the newest one, skipping the ones which are still needed.
+    do {
+        HEAD = (HEAD + 1) & (EE_SLOTS - 1);
+    } while(slotLive(HEAD));
+    DST = HEAD;
+    POS = 0;
+
+    // Records that were not touched for a long time are rewritten, so their sequence numbers stay comparable.
+    for(i = 0; i < OG_TAGS; i++)
+        if(i != tag && SLOT_OF[i] != EE_SLOTS && (uint8_t)(SEQ - SEQ_OF[i]) > OG_EE_REFRESH_AGE)
+            DIRTY |= 1 << i;
+}
+
+void eeJournalInit(void) {
+    uint8_t slot, tag, seq, size, found = 0;
+    eeRecord r;
+
+    memset(SLOT_OF, EE_SLOTS, sizeof(SLOT_OF));
+    for(slot = 0; slot < EE_SLOTS; slot++) {
+        tag = eeprom_read_byte(EE_ADDR(slot, 0)) ^ EE_LAYOUT;
+        if(tag >= OG_TAGS) continue;                // Erased slot, other layout or a record of an older firmware.
+        seq = eeprom_read_byte(EE_ADDR(slot, 1));
+        // Only copies newer than the best one found so far are checked, which keeps the boot scan short.
+        if(SLOT_OF[tag] != EE_SLOTS && (int8_t)(seq - SEQ_OF[tag]) <= 0) continue;
+        if(!slotValid(slot)) continue;
+
+        SLOT_OF[tag] = slot;
+        SEQ_OF[tag] = seq;
+    }
+
+    // Loading the found records and continuing the journal after the newest one.
+    for(tag = 0; tag < OG_TAGS; tag++) {
+        slot = SLOT_OF[tag];
+        if(slot == EE_SLOTS) continue;
+
+        recordGet(tag, &r);
+        size = eeprom_read_byte(EE_ADDR(slot, 2));
+        eeprom_read_block(r.data, EE_ADDR(slot, 3), size < r.size ? size : r.size);
+        if(!found++ || (int8_t)(SEQ_OF[tag] - SEQ) > 0) {
+            SEQ = SEQ_OF[tag];
+            HEAD = slot;
+        }
+    }
+}
+
+void eeJournalSave(uint8_t tag) {
+    DIRTY |= 1 << tag;
+}
+
+void eeJournalTask(void) {
+    if(POS == EE_IDLE) {
+        if(!DIRTY) return;
+        recordStage();
+    }
+    if(!eeprom_is_ready()) return;          // Previous byte is still being programmed.
+
+    eeprom_update_byte(EE_ADDR(DST, POS), SLOT[POS]);
+    if(++POS == OG_EE_SLOT_SIZE) {          // The new copy is complete and replaces the old one.
+        SLOT_OF[SLOT[0] & EE_TAG_MASK] = DST;
+        SEQ_OF[SLOT[0] & EE_TAG_MASK] = SLOT[1];
+        POS = EE_IDLE;
+    }
+}
+
+uint8_t eeJournalBusy(void) {
+    return POS != EE_IDLE || DIRTY;
+}
@@ -0,0 +1,44 @@
+/*
+ *  Wear-leveled EEPROM journal for 'Open Game Pad' settings and counters.
+ *
+ *  The EEPROM is split into fixed size slots. Every save appends the record into the next free slot instead of rewriting
+ *  a fixed address, so the writes rotate through the whole EEPROM. Each record carries its tag, an 8-bit sequence number,
+ *  its size and a CRC-16, therefore a torn write or a worn out cell only ever loses the newest copy of one record.
+ * */
+
+#ifndef __EEJOURNAL_H__
+#define __EEJOURNAL_H__
+
+#include <stdint.h>
+#include "ogconfig.h"
+
+// Amount of slots in the EEPROM.
+#define EE_SLOTS        (OG_EE_SIZE / OG_EE_SLOT_SIZE)
+// Largest payload one record can carry: slot size without tag, sequence, size and CRC bytes.
+#define EE_PAYLOAD      (OG_EE_SLOT_SIZE - 5)
+// Tag value of an erased slot.
+#define EE_TAG_EMPTY    0xFF
+
+/*
+ *  Journal record description.
+ *
+ *  Each tag is bound to the RAM image of the data it stores. The table of those descriptions is provided by the owner of
+ *  the data as EE_RECORDS and is indexed by tag.
+ * */
+typedef struct {
+    void *data;             // RAM image of the record.
+    uint8_t size;           // Size of the RAM image, not more than EE_PAYLOAD.
+} eeRecord;
+
+/* Scans the EEPROM and loads the newest valid copy of every record into its RAM image. Records that were never saved
+ * keep the defaults their RAM images already hold, and so do the fields a record saved by an older firmware is too short
+ * to cover. New fields therefore always go to the end of a record. */
+void eeJournalInit(void);
+/* Marks the record as changed. It is written in the background by eeJournalTask(). */
+void eeJournalSave(uint8_t tag);
+/* Background writer. Must be called from the main loop, programs at most one byte per call and never waits for the EEPROM. */
+void eeJournalTask(void);
+/* Returns non zero while some record is still waiting to be written. */
+uint8_t eeJournalBusy(void);
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ *  Adaptive axis filter of 'Open Game Pad'.
+ * */
+
+#include "filter.h"
+#include "settings.h"
+
+// Filtered axes in 8.8 fixed point, their last rounded output and the output last taken over into the reports.
+static uint16_t VALUE[OG_AXES];
+static uint8_t OUTPUT[OG_AXES];
+static uint8_t HELD[OG_AXES];
+// Mean distance of the raw readings from the output in 8.8 fixed point, the noise floor of each axis.
+static uint16_t NOISE[OG_AXES];
+// Milliseconds each axis has been resting, up to REST_MS.
+static uint8_t REST[OG_AXES];
+// Rest needed before the noise floor follows an axis, the length of its average.
+#define REST_MS     32
+
+// Distance of two readings.
+static uint8_t distance(uint8_t a, uint8_t b) {
+    return a > b ? a - b : b - a;
+}
+
+/*
+ * The step towards the raw reading is taken on the unsigned distance, so the 8.8 values never overflow. The shift makes
+ * each step at least 2^-k of the distance, the value settles within one count of the raw reading.
+ *
+ * The noise floor averages the distance of the raw reading from the output over about 32 ms, limited to 15 counts. The
+ * automatic band is twice this average rounded to whole counts, which covers most of the noise peaks. While the stick
+ * moves that distance is mostly the lag of the filter, so the average only follows an axis which rested for REST_MS: its
+ * output stayed within OG_CENTER_RANGE of the center, as for the center tracking, and each step was below half a count.
+ * */
+uint8_t filterUpdate(const frame_t *frame) {
+    uint8_t changed = 0;
+
+    for(uint8_t i = 0; i < OG_AXES; i++) {
+        uint16_t raw = (uint16_t) frame->axes[i] << 8, value = VALUE[i], dist = raw > value ? raw - value : value - raw;
+        uint8_t k = TUNING.filterRest[i], fast = (dist >> 8) >> TUNING.filterSpeed[i];
+
+        k = k > fast ? k - fast : 0;
+        dist >>= k;
+        if(raw > value) value += dist;
+        else value -= dist;
+        VALUE[i] = value;
+
+        uint8_t out = value >= 0xFF80 ? 0xFF : (value + 0x80) >> 8;
+        uint8_t dev = distance(frame->axes[i], out);
+        if(dev > 15) dev = 15;
+        if(dist >= 0x80 || distance(out, CALIB.center[i]) > OG_CENTER_RANGE) REST[i] = 0;
+        else if(REST[i] < REST_MS) REST[i]++;
+        else NOISE[i] += ((int16_t) ((uint16_t) dev << 8) - (int16_t) NOISE[i]) >> 5;
+        OUTPUT[i] = out;
+
+        // Only a move out of the band around the held output is a change, the buttons are compared exactly by the scan.
+        uint8_t band = TUNING.filterBand[i] == OG_FILTER_BAND_AUTO ? (NOISE[i] + 0x40) >> 7 : TUNING.filterBand[i];
+        if(distance(out, HELD[i]) > band) {
+            HELD[i] = out;
+            changed = 1;
+        }
+    }
+
+    return changed;
+}
+
+void filterApply(frame_t *frame) {
+    for(uint8_t i = 0; i < OG_AXES; i++) frame->axes[i] = HELD[i];
+}
+
+void filterRead(frame_t *frame) {
+    for(uint8_t i = 0; i < OG_AXES; i++) frame->axes[i] = OUTPUT[i];
+}
@@ -0,0 +1,35 @@
+/*
+ *  Adaptive axis filter of 'Open Game Pad'.
+ *
+ *  Every axis keeps its filtered value in 8.8 fixed point. Once per millisecond the value moves towards the latest raw
+ *  reading by the distance between both, shifted right by k. The shift is the rest setting of the axis, lowered by one for
+ *  every 2^speed counts of that distance. A stick at rest is smoothed heavily, while a fast move leaves the raw value far
+ *  behind, drops the shift to 0 and passes without lag. The distance stands in for the speed estimate of a one-euro
+ *  filter, so neither a division nor a multiplication is needed.
+ *
+ *  The reports take over the output only when it leaves a band around the value they carry, so noise alone never causes
+ *  a report. The band of each axis is set in the TUNING record or follows the measured noise floor of the axis.
+ *
+ *  The loop body is shifts, adds and compares on 8- and 16-bit values, without a multiplication or division. 'make bench'
+ *  measures one call over all axes in the simulator, at rest (benchFilterRest) and on a full stroke (benchFilterMove),
+ *  and keeps both in the baseline. No figure is given here until that has been run.
+ * */
+
+#ifndef __FILTER_H__
+#define __FILTER_H__
+
+#include <stdint.h>
+
+#include "ogpad.h"
+
+// Band setting that follows the noise floor.
+#define OG_FILTER_BAND_AUTO     0xFF
+
+/* Filters the raw axes of the frame. Must be called once per millisecond. Returns non zero if any axis left its band. */
+uint8_t filterUpdate(const frame_t *frame);
+/* Replaces the raw axes of the frame with the ones for the reports, held within their bands. */
+void filterApply(frame_t *frame);
+/* Replaces the raw axes of the frame with the filtered ones. */
+void filterRead(frame_t *frame);
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ *  Hardware abstraction of 'Open Game Pad'.
+ *
+ *  The firmware reaches the MCU registers only through the backend selected here from the -mmcu of the compiler. Every
+ *  backend provides the same names:
+ *  - the USB pins and the part features as plain preprocessor values, read by usbconfig.h and therefore the assembler;
+ *  - the interrupt vectors of the D- pin change and of the clock tick;
+ *  - inline functions for the scan clock and DIN line, the ADC, the pin change input, the clock timer and the watchdog.
+ *
+ *  Everything is resolved at compile time. The inline functions compile to the same instructions as the direct register
+ *  access they replace, so the backend costs neither flash nor cycles.
+ *
+ *  The scan lines are the same on every backend: CLK drives the counter, DIN carries the key of the current counter
+ *  state and must be bit 0 of the port read by halScanPins(), AIN is the ADC input of the multiplexer (see scan.h).
+ * */
+
+#ifndef __HAL_H__
+#define __HAL_H__
+
+#if defined(__AVR_ATtiny85__)
+#include "haltiny85.h"
+#elif defined(__AVR_ATmega328P__)
+#include "halmega328.h"
+#else
+#error "no hardware backend for this MCU, see hal.h"
+#endif
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ *  ATmega328P backend of the hardware abstraction, see hal.h.
+ *
+ *  Runs from a 16 MHz or 20 MHz crystal, V-USB picks usbdrvasm16.inc or usbdrvasm20.inc from F_CPU. The oscillator needs
+ *  no calibration. The bootloader in boot/ is only built for the ATtiny85, so OG_RQ_BOOTLOADER is not answered.
+ *
+ *  PB0: DIN    PB4: CLK    PC0: AIN (ADC0)    PD2: D+ (INT0)    PD4: D-
+ *
+ *  The scan lines keep their ATtiny85 port, so the board only moves the USB lines and AIN.
+ * */
+
+#ifndef __HALMEGA328_H__
+#define __HALMEGA328_H__
+
+#define OG_HAL_USB_PORT         D
+#define OG_HAL_USB_DMINUS       4
+#define OG_HAL_USB_DPLUS        2
+#define OG_HAL_OSCCAL           0
+#define OG_HAL_BOOTLOADER       0
+// Timer2 can not count 1 ms in 256 counts from these clocks. It is cleared after OG_HAL_TIMER_COUNTS counts instead.
+#if F_CPU > 16000000
+#define OG_HAL_TIMER_COUNTS     156
+#define OG_HAL_TIMER_PRESCALE   128
+#else
+#define OG_HAL_TIMER_COUNTS     250
+#define OG_HAL_TIMER_PRESCALE   64
+#endif
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+#include<avr/io.h>
+
+#define OG_HAL_PCINT_vect       PCINT2_vect
+#define OG_HAL_TIMER_vect       TIMER2_COMPA_vect
+
+static inline void halPinsInit(void) {
+    DDRB = 1 << PB4;
+    PCMSK2 = 1 << PCINT20;
+}
+
+static inline void halPinChangeEnable(void) {
+    PCICR |= 1 << PCIE2;
+}
+
+static inline void halClockToggle(void) {
+    PINB = 1 << PB4;
+}
+
+static inline uint8_t halScanPins(void) {
+    return PINB;
+}
+
+// Same as on the ATtiny85, but AVcc must be selected as the reference. At 20 MHz the ADC clock is CK/32.
+static inline void halAdcInit(void) {
+    ADMUX = (1 << REFS0) | (1 << ADLAR);
+#if F_CPU > 16000000
+    ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADIE) | (1 << ADIF) | (1 << ADPS2) | (1 << ADPS0);
+#else
+    ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADIE) | (1 << ADIF) | (1 << ADPS2);
+#endif
+}
+
+static inline void halAdcStop(void) {
+    ADCSRA = 0;
+}
+
+static inline void halAdcStart(void) {
+    ADCSRA |= 1 << ADSC;
+}
+
+static inline uint8_t halAdcRead(void) {
+    return ADCH;
+}
+
+// Timer2 in CTC mode, its compare interrupt ticks every 1.000 ms at 16 MHz and 0.998 ms at 20 MHz.
+static inline void halTimerInit(void) {
+    OCR2A = OG_HAL_TIMER_COUNTS - 1;
+    TCCR2A = 1 << WGM21;
+#if OG_HAL_TIMER_PRESCALE == 128
+    TCCR2B = (1 << CS22) | (1 << CS20);
+#else
+    TCCR2B = 1 << CS22;
+#endif
+    TIMSK2 = 1 << OCIE2A;
+}
+
+static inline uint8_t halTimerCount(void) {
+    return TCNT2;
+}
+
+static inline void halWdtInterrupt(uint8_t wdto) {
+    WDTCSR = (1 << WDCE) | (1 << WDE);
+    WDTCSR = (1 << WDIE) | (wdto & 7) | (wdto & 8 ? 1 << WDP3 : 0);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ *  ATtiny85 backend of the hardware abstraction, see hal.h.
+ *
+ *  The original pad: the internal RC oscillator is calibrated to 16.5 MHz against the USB frames (see osccal.h) and the
+ *  HID bootloader in boot/ takes the end of the flash.
+ *
+ *  PB0: DIN    PB1: D-    PB2: D+ (INT0)    PB3: AIN (ADC3)    PB4: CLK
+ * */
+
+#ifndef __HALTINY85_H__
+#define __HALTINY85_H__
+
+// USB port and lines, for usbconfig.h.
+#define OG_HAL_USB_PORT         B
+#define OG_HAL_USB_DMINUS       1
+#define OG_HAL_USB_DPLUS        2
+// Set to 1 if the oscillator is calibrated against the USB frames.
+#define OG_HAL_OSCCAL           1
+// Set to 1 if the HID bootloader can be entered with OG_RQ_BOOTLOADER.
+#define OG_HAL_BOOTLOADER       1
+// Counts of the clock timer per tick and CPU cycles per count, see clock.h.
+#define OG_HAL_TIMER_COUNTS     256
+#define OG_HAL_TIMER_PRESCALE   64
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+#include<avr/io.h>
+
+#define OG_HAL_PCINT_vect       PCINT0_vect
+#define OG_HAL_TIMER_vect       TIMER1_OVF_vect
+
+// Makes CLK an output and selects D- as the only pin change source. PB1 and PB2 are handled by V-USB.
+static inline void halPinsInit(void) {
+    DDRB = 1 << PB4;
+    PCMSK = 1 << PCINT1;
+}
+
+// Enables the pin change interrupt. INT0 stays enabled for V-USB.
+static inline void halPinChangeEnable(void) {
+    GIMSK |= 1 << PCIE;
+}
+
+// Toggles CLK. Writing PINB avoids a read-modify-write of PORTB, which the V-USB interrupt could cut in two.
+static inline void halClockToggle(void) {
+    PINB = 1 << PB4;
+}
+
+// Reads the port of the scan lines, DIN is bit 0.
+static inline uint8_t halScanPins(void) {
+    return PINB;
+}
+
+/*
+ * Starts the ADC with the first conversion and its interrupt.
+ *
+ * - Only the 8 high bits are used, so the ADC clock runs at 1 MHz (CK/16) for faster conversions, the limit declared in
+ *   the datasheet. They are left adjusted into ADCH.
+ * - Single ended input on AIN (ADC3) with the Vcc voltage reference.
+ * */
+static inline void halAdcInit(void) {
+    ADMUX = (1 << MUX1) | (1 << MUX0) | (1 << ADLAR);
+    ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADIE) | (1 << ADIF) | (1 << ADPS2);
+}
+
+static inline void halAdcStop(void) {
+    ADCSRA = 0;
+}
+
+static inline void halAdcStart(void) {
+    ADCSRA |= 1 << ADSC;
+}
+
+static inline uint8_t halAdcRead(void) {
+    return ADCH;
+}
+
+// Timer1 runs from CK/64 and overflows every 256 * 64 / 16.5 MHz = 0.993 ms.
+static inline void halTimerInit(void) {
+    TCCR1 = (1 << CS12) | (1 << CS11) | (1 << CS10);
+    TIMSK |= 1 << TOIE1;
+}
+
+static inline uint8_t halTimerCount(void) {
+    return TCNT1;
+}
+
+// Switches the watchdog to interrupt mode with the WDTO_* period. Interrupts must be disabled and the watchdog reset.
+static inline void halWdtInterrupt(uint8_t wdto) {
+    WDTCR = (1 << WDCE) | (1 << WDE);
+    WDTCR = (1 << WDIE) | (wdto & 7) | (wdto & 8 ? 1 << WDP3 : 0);
+}
+
+#endif
+
+#endif
@@ -10,59 +10,142 @@
 #include<avr/pgmspace.h>
 #include<avr/interrupt.h>
 
-#include<avr/delay.h>
+#include<util/delay.h>
+#include<avr/eeprom.h>
+#include<avr/sleep.h>
 #include<avr/wdt.h>
 #include<avr/io.h>
 
 #include "../usbdrv/usbdrv.h"
+#include "eejournal.h"
+#include "settings.h"
+#include "hal.h"
+#if OG_HAL_OSCCAL
+#include "osccal.h"
+#endif
+#include "clock.h"
+#include "scan.h"
+#include "filter.h"
+#include "stick.h"
+#include "center.h"
+#include "socd.h"
+#include "remap.h"
+#include "stack.h"
 #include "ogpad.h"
 
+// Game Pad report holds the current pressed keys and joystick axises derivatives.
+report_t REPORT;
 // Pointer to the REPORT structure.
 static report_t *RPTR = &REPORT;
+// Milliseconds since the last interrupt report.
+static uint16_t REPORT_AGE;
+// Press latches carried by the interrupt report that waits in the driver. Cleared once the host took it.
+static uint32_t REPORT_LATCHED;
+#if OG_REPORT_SIZE > 8
+// Bytes of a long report which still wait for their packet.
+static uint8_t REPORT_LEFT;
+#else
+#define REPORT_LEFT 0
+#endif
+// Runtime statistics.
+stats_t STATS;
+// Milliseconds since power up.
+uint16_t CLOCK_MS;
+volatile uint8_t CLOCK_TICKS;
+// Set by every edge on D-. Cleared by the main loop each millisecond.
+static volatile uchar BUS_ACTIVE;
+// Milliseconds the bus stayed in the idle J state.
+static uchar BUS_IDLE;
+// Time of the last wake-up. RESUMING stays set until the first report after it is sent.
+static uint16_t RESUME_AT;
+static uchar RESUMING;
 // Determines how often the device should send a report to the host when there is no change in the state of the inputs.
 static uchar IDLE_RATE;
-// Inpur counter allows to define which key we are reading as a digital input or which axis as an analog input.
-static volatile inputCounter ic = { .raw = 0 };
+#if OG_EDGE_TIMES
+// Position of the next time stamp byte sent by usbFunctionRead(), or TIMING_IDLE while it sends the configuration blob.
+#define TIMING_IDLE 0xFF
+static uint8_t TIMING_POS = TIMING_IDLE;
+#endif
+// Set once the host asked for the bootloader. The restart waits until the status of the request is sent.
+static uchar BOOT_REQUEST;
+// Transmit status of the driver. Has bit 4 set while nothing waits for the host.
+extern volatile uchar usbTxLen;
+// Length of the message received by the driver. Non zero until usbPoll() handled it.
+extern volatile schar usbRxLen;
 
 /* 
  * Game Pad report descriptor. 
  *
- * It defines a device's buttons and joysticks via USB report descriptor. 
+ * It defines a device's buttons and joysticks via USB report descriptor. The items are generated from the report table
+ * in report.h.
  * */
-PROGMEM const char usbDescriptorHidReport[USB_CFG_HID_REPORT_DESCRIPTOR_LENGTH] = {
-    // Global information.
-    0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
-    0x09, 0x05,                    // USAGE (Gamepad)
-    0xA1, 0x01,                    // COLLECTION (Application)
-    0xA1, 0x00,                    //   COLLECTION (Physical)
-    // 18 buttons handling.
-    0x05, 0x09,                    //     USAGE_PAGE (Button)
-    0x19, 0x01,                    //     USAGE_MINIMUM (Button 1)
-    0x29, 0x12,                    //     USAGE_MAXIMUM (Button 18)
-    0x15, 0x00,                    //     LOGICAL_MINIMUM (0)
-    0x25, 0x01,                    //     LOGICAL_MAXIMUM (1)
-    0x95, 0x12,                    //     REPORT_COUNT (18)
-    0x75, 0x01,                    //     REPORT_SIZE (1)
-    0x81, 0x02,                    //     INPUT (Data,Var,Abs)
-    // Unused bits are ignored.
-    0x95, 0x01,                    //     REPORT_COUNT (1)
-    0x75, 0x0D,                    //     REPORT_SIZE (14)
-    0x81, 0x03,                    //     INPUT (Cnst,Var,Abs)
-    // Joysticks handling.
-    0x05, 0x01,                    //     USAGE_PAGE (Generic Desktop)
-    0x09, 0x30,                    //     USAGE (X)
-    0x09, 0x31,                    //     USAGE (Y)
-    0x09, 0x32,                    //     USAGE (Z)
-    0x09, 0x33,                    //     USAGE (Rx)
-    0x15, 0x81,                    //     LOGICAL_MINIMUM (-127)
-    0x25, 0x7F,                    //     LOGICAL_MAXIMUM (127)
-    0x75, 0x08,                    //     REPORT_SIZE (8)
-    0x95, 0x04,                    //     REPORT_COUNT (4)
-    0x81, 0x02,                    //     INPUT (Data,Var,Abs)
-    // Closing collections.
-    0xC0,                          //   END_COLLECTION
-    0xC0                           // END_COLLECTION
+PROGMEM const char usbDescriptorHidReport[] = OG_REPORT_DESCRIPTOR;
+
+_Static_assert(sizeof(usbDescriptorHidReport) == USB_CFG_HID_REPORT_DESCRIPTOR_LENGTH, "report descriptor length mismatch");
+
+#if OG_REPORT_COMPACT
+/*
+ * Hat switch value for each combination of the d-pad keys (bit 0 up, 1 right, 2 down, 3 left).
+ *
+ * Opposite directions cancel each other, so pressing both leaves the other axis alone.
+ * */
+PROGMEM static const uint8_t HAT[16] = {
+    8, 0, 2, 1, 4, 8, 3, 2, 6, 7, 8, 0, 5, 6, 4, 8
 };
+#endif
+
+/*
+ * Centers the raw reading of axis 'i' on its rest value and stretches each side to the calibrated end of the axis.
+ * The result saturates to -127..127, readings beyond the ends give full deflection. A side that spans 127 counts or
+ * more, as both do without calibration, is only clamped. The others take one division.
+ * */
+static int8_t reportAxis(uchar i, uint8_t raw) {
+    int16_t value = (int16_t) raw - CALIB.center[i];
+    uint8_t span = value < 0 ? CALIB.center[i] - CALIB.min[i] : CALIB.max[i] - CALIB.center[i];
+
+    if(span && span < 127) value = value * 127 / span;
+
+    return value > 127 ? 127 : value < -127 ? -127 : value;
+}
+
+/*
+ * Packs the scanned inputs into REPORT.
+ *
+ * The frame is copied atomically, so a report never mixes two scans. Each axis is filtered (see filter.h), centered
+ * and scaled (see reportAxis()) and shaped as a part of its joystick (see stick.h). A key that was pressed since its
+ * latch was last cleared is reported as pressed, so a tap shorter than the poll interval still reaches the host.
+ * Opposite d-pad directions are resolved (see socd.h) before the keys are mapped to the report bits of the active
+ * profile (see remap.h). Returns the latched keys.
+ * */
+static uint32_t reportPack(void) {
+    frame_t frame;
+
+    scanRead(&frame);
+    filterApply(&frame);
+    frame.bmask = remapApply(socdApply(frame.bmask | frame.pressed));
+
+#if OG_REPORT_COMPACT
+    RPTR->hat = pgm_read_byte(&HAT[frame.bmask & 0x0F]);
+    RPTR->bmask = frame.bmask >> 4;
+#else
+    RPTR->bmask = frame.bmask;
+#endif
+    for(uchar i = 0; i < OG_AXES; i++) RPTR->joyax[i] = reportAxis(i, frame.axes[i]);
+    stickApply(RPTR->joyax);
+
+    return frame.pressed;
+}
+
+#if OG_REPORT_SIZE > 8
+// Hands the next packet of the report to the driver. Only the last packet is shorter than 8 bytes, which ends the
+// transfer. A GET_REPORT request in between packs REPORT anew, so the packets still to come may carry a newer frame.
+static void reportSend(void) {
+    uint8_t len = REPORT_LEFT > 8 ? 8 : REPORT_LEFT;
+
+    usbSetInterrupt((uchar *) RPTR + sizeof(REPORT) - REPORT_LEFT, len);
+    REPORT_LEFT -= len;
+}
+#endif
 
 // This is the function from the V-USB library that must be defined here to properly handle the requests from the host.
 usbMsgLen_t usbFunctionSetup(uchar raw[8]) {
@@ -72,6 +155,7 @@ usbMsgLen_t usbFunctionSetup(uchar raw[8]) {
     if((req->bmRequestType & USBRQ_TYPE_MASK) == USBRQ_TYPE_CLASS){
         if(req->bRequest == USBRQ_HID_GET_REPORT){  /* wValue: ReportType (highbyte), ReportID (lowbyte) */
             // we only have one report type, so don't look at wValue
+            reportPack();
             usbMsgPtr = (void *) RPTR;
             return sizeof(REPORT);
         }else if(req->bRequest == USBRQ_HID_GET_IDLE){
@@ -80,67 +164,173 @@ usbMsgLen_t usbFunctionSetup(uchar raw[8]) {
         }else if(req->bRequest == USBRQ_HID_SET_IDLE){
             IDLE_RATE = req->wValue.bytes[1];
         }
-    }else{
-        /* Vendor specific requests could be implemented here to built up the firmware abilities. */
+    }else if((req->bmRequestType & USBRQ_TYPE_MASK) == USBRQ_TYPE_VENDOR){
+        // Configuration blob is streamed through usbFunctionRead() and usbFunctionWrite() in 8 byte chunks.
+        if(req->bRequest == OG_RQ_CONFIG_READ || req->bRequest == OG_RQ_CONFIG_WRITE){
+#if OG_EDGE_TIMES
+            TIMING_POS = TIMING_IDLE;
+#endif
+            settingsTransferStart(req->wLength.word);
+            return USB_NO_MSG;
+        }else if(req->bRequest == OG_RQ_PROFILE){
+            remapProfile(req->wValue.bytes[0]);
+        }else if(OG_HAL_BOOTLOADER && req->bRequest == OG_RQ_BOOTLOADER){
+            BOOT_REQUEST = 1;
+        }else if(req->bRequest == OG_RQ_STATS){
+            STATS.stackFree = stackFree();
+            usbMsgPtr = (void *) &STATS;
+            return sizeof(STATS);
+#if OG_EDGE_TIMES
+        }else if(req->bRequest == OG_RQ_TIMING){
+            // The scan keeps writing the time stamps, so they are copied one by one as the chunks are sent.
+            TIMING.now = clockStamp();
+            TIMING_POS = 0;
+            return USB_NO_MSG;
+#endif
+        }
     } 
 
     return 0;
 }
 
-#define abs(x) ((x) > 0 ? (x) : (-x))
+// Sends the next chunk of the time stamps or of the configuration blob.
+uchar usbFunctionRead(uchar *data, uchar len) {
+#if OG_EDGE_TIMES
+    if(TIMING_POS != TIMING_IDLE) {
+        if(len > sizeof(TIMING) - TIMING_POS) len = sizeof(TIMING) - TIMING_POS;
+        scanTimes(data, TIMING_POS, len);
+        TIMING_POS += len;
+        return len;
+    }
+#endif
+    return settingsRead(data, len);
+}
+
+// Receives the next chunk of the configuration blob. Records are applied as they arrive, also when a later one fails,
+// so the button map is checked again after every chunk.
+uchar usbFunctionWrite(uchar *data, uchar len) {
+    uchar done = settingsWrite(data, len);
 
-// Calibrates the RC oscillator to 16.5 MHz speeds.
+    remapBuild();
+    return done;
+}
+
+#if OG_HAL_OSCCAL
+// Calibrates the RC oscillator to 16.5 MHz speeds after every USB reset and keeps the result for the next boot.
 void hadUsbReset(void) {
-    int frameLength, targetLength = (unsigned)(1499 * (double)F_CPU / 10.5e6 + 0.5);
-    int bestDeviation = 9999;
-    uchar trialCal, bestCal, step, region;
-
-    // do a binary search in regions 0-127 and 128-255 to get optimum OSCCAL
-    for(region = 0; region <= 1; region++) {
-        frameLength = 0;
-        trialCal = (region == 0) ? 0 : 128;
-        
-        for(step = 64; step > 0; step >>= 1) { 
-            if(frameLength < targetLength) // true for initial iteration
-                trialCal += step; // frequency too low
-            else
-                trialCal -= step; // frequency too high
-                
-            OSCCAL = trialCal;
+    settingsSaveOsccal(osccalCalibrate());
+}
+#endif
 
-            cli();
-            frameLength = usbMeasureFrameLength();
-            sei();
+/*
+ * Restarts the pad into the bootloader.
+ *
+ * The magic is left in RAM with interrupts disabled for good, so nothing overwrites it before the watchdog reset.
+ * */
+static void __attribute__((noreturn)) bootloaderEnter(void) {
+    cli();
+    *(volatile uint16_t *) BOOT_MAGIC_ADDR = BOOT_MAGIC;
+    usbDeviceDisconnect();
+    wdt_enable(WDTO_15MS);
+    for(;;);
+}
 
-            if(abs(frameLength-targetLength) < bestDeviation) {
-                bestCal = trialCal; // new optimum found
-                bestDeviation = abs(frameLength -targetLength);
-            }
+// Switches the watchdog to interrupt mode. It then only wakes the CPU up, instead of resetting it.
+static void wdtInterrupt(uchar wdto) {
+    cli();
+    wdt_reset();
+    halWdtInterrupt(wdto);
+    sei();
+}
+
+/*
+ * Suspends the pad until the host resumes the bus.
+ *
+ * The scan and the watchdog are stopped and the CPU is powered down. An edge on D- wakes it up again, it is the
+ * only pin change interrupt source. The oscillator needs 16K cycles (about 1 ms) to start, well within the 10 ms
+ * the host gives after resume signalling ends.
+ *
+ * If the host allows remote wakeup, the watchdog wakes the CPU every OG_WAKE_SCAN to look for a pressed key. The bus
+ * has been idle for more than 5 ms by the first wake scan, as required before resume signalling.
+ * */
+static void suspend(void) {
+    scanStop();
+    wdt_disable();
+    STATS.suspends++;
+    if(usbRemoteWakeup) wdtInterrupt(OG_WAKE_SCAN);
+
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    for(;;) {
+        cli();
+        if(BUS_ACTIVE) break;
+        sleep_enable();
+#if defined(BODS)
+        sleep_bod_disable();
+#endif
+        sei();                             // The instruction after 'sei' always runs, so no edge can slip in before sleeping.
+        sleep_cpu();
+        sleep_disable();
+
+        if(!BUS_ACTIVE && usbRemoteWakeup && scanWake()) {
+            cli();
+            usbRemoteWakeupSignal();
+            STATS.remoteWakeups++;
+            break;
         }
     }
+    sei();
 
-    OSCCAL = bestCal;
+    RESUME_AT = clockNow();
+    RESUMING = 1;
+    SCAN_NEW = 1;
+    BUS_ACTIVE = 0;
+    BUS_IDLE = 0;
+    wdt_enable(WDTO_1S);
+    scanStart();
+}
+
+// Wakes the CPU up for the key scan while suspended.
+EMPTY_INTERRUPT(WDT_vect);
+
+/*
+ * Sleeps until the next interrupt if the main loop has nothing to do.
+ *
+ * Every interrupt wakes the CPU: the USB interrupt, the scan interrupts and the clock tick. The loop then runs once more,
+ * so usbPoll() follows a received packet as soon as without sleeping. The check and the sleep are atomic, an interrupt
+ * that arrives in between keeps the CPU awake.
+ * */
+static void idle(void) {
+#if OG_IDLE_SLEEP
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    cli();
+    if(usbRxLen <= 0 && !((SCAN_NEW || REPORT_LATCHED || REPORT_LEFT) && usbInterruptIsReady()) && !clockPending()) {
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    }
+    sei();
+#endif
 }
 
 // Main function that initializes registers with required values and then waits for interrupts.
 int __attribute__((noreturn)) main(void) {
     wdt_disable();
     /*      GPIO Configuration      */
-    // PB1, PB2 lines are handled by V-USB. PB0 is a digital input line by default. 
-    // The clock is being bit-banged inside the ADC interrupt handler.
-    DDRB = 1 << PB4;        // CLK output.
-    PCMSK = 1 << PCINT0;    // The PCINT interrupt will be invoked only when something changes on PB0.
-
-    /*      ADC Configuration       */
-    // - Only 8 highest bits are required, therefore 1 Mhz sampling can be used for faster conversion. This sampling is a limit declared 
-    // in the datasheet;
-    // - Holding high bits in ADCH as a result;
-    // - Single ended input with internal Vcc voltage reference is being used;
-    ADCSRA = (1 << ADPS2) | (1 << ADSC) | (1 << ADIF);
-    ADMUX = (1 << MUX1) | (1 << MUX0) | (1 << ADLAR);
+    // The USB lines are handled by V-USB. DIN is a digital input line by default.
+    // The clock is being bit-banged inside the ADC interrupt handler, see scan.c.
+    halPinsInit();          // CLK output, the pin change interrupt is invoked when something changes on D-.
 
     wdt_enable(WDTO_1S);                   // Enabling the watchdog timer and selecting the 1s expiring.
-    
+
+    // Loading the stored settings. The stored OSCCAL lets the first frames be received before the calibration runs.
+    settingsInit();
+    centerInit();
+    remapBuild();
+#if OG_HAL_OSCCAL
+    if(CALIB.osccal != OG_OSCCAL_UNSET) OSCCAL = CALIB.osccal;
+#endif
+
     usbDeviceDisconnect();                    // Forcing re-enumeration.
     wdt_reset();                           // One second is enough for the next step.
     uchar i = 0;
@@ -150,44 +340,99 @@ int __attribute__((noreturn)) main(void) {
     }                       
     usbDeviceConnect();
     usbInit();                             // Start of USB handling.
+    clockInit();
+    scanStart();
 
-    GIMSK = 1 << PCIE;
-    // Main loop only handles the USB connection and resets the watchdog timer.
+    halPinChangeEnable();
+    // Main loop handles the USB connection, resets the watchdog timer and does the slow bookkeeping.
+    uint32_t prev = 0;
+    frame_t frame;
     sei();
     for(;;) {
         wdt_reset();
         usbPoll();                         // Polling the USB lines
         
-        // Here we are sending the current data we have.
-        if(usbInterruptIsReady()) {        // If interrupt is ready, sending the newest data.
+#if OG_REPORT_SIZE > 8
+        // A long report takes one packet per interrupt poll, the host joins them up to the short last one. With the
+        // 10 ms polling of low speed a 12 byte report takes two polls.
+        if(usbInterruptIsReady() && REPORT_LEFT) reportSend();
+#endif
+
+        // The driver frees its buffer once the host took the report, only then the latches it carried are cleared. A key
+        // released in the meantime needs one more report to show it.
+        if(usbInterruptIsReady() && !REPORT_LEFT && REPORT_LATCHED) {
+            scanLatchClear(REPORT_LATCHED);
+            REPORT_LATCHED = 0;
+            SCAN_NEW = 1;
+        }
+
+        // Here we are sending the current data we have. Without a change the report is repeated at the idle rate (4 ms units).
+        if(usbInterruptIsReady() && !REPORT_LEFT && (SCAN_NEW || (IDLE_RATE && REPORT_AGE >= IDLE_RATE * 4))) {
+            SCAN_NEW = 0;
+            REPORT_AGE = 0;
+            REPORT_LATCHED = reportPack();
+#if OG_REPORT_SIZE > 8
+            REPORT_LEFT = sizeof(REPORT);
+            reportSend();
+#else
             usbSetInterrupt((void *) RPTR, sizeof(REPORT));
+#endif
+            if(RESUMING) {
+                STATS.resumeLatency = clockNow() - RESUME_AT;
+                RESUMING = 0;
+            }
         }
-    }
-}
 
-/* 
- * This interrupt handles ADC data on AIN line. 
- *
- * It also does the output clock control by bitbanging, so all outside components are dependent on
- * ADC convertion. This way it is possible to decode all digital and analog inputs.
- * */
-ISR(ADC_vect) {
-    PORTB ^= (1 << PB4);                          // Clock tick.
-    RPTR->joyax[ic.ANALOG] = ADCH;                // Writing the next analog input to the proper location.
-    ADCSRA |= (1 << ADSC);                        // Starting new ADC conversion.
-    ic.raw++;
+        // The host keeps the bus busy at least once per millisecond until it suspends the pad. Without an edge D- kept its
+        // level for the whole millisecond, so one sample tells the idle J state (D- high) from a bus reset (SE0, D- low
+        // for 10 ms or more). Only the J state counts towards the suspend, usbPoll() handles the reset. A byte being
+        // written to the EEPROM is let to finish, the rest of the journal continues after the resume.
+        if(clockPoll()) {
+            if(REPORT_AGE < 0xFFFF) REPORT_AGE++;
+            scanPace();
+            scanRead(&frame);
+            if(filterUpdate(&frame)) SCAN_NEW = 1;
+#if OG_CENTER_TRACK
+            centerUpdate(&frame);
+#endif
+            if(BUS_ACTIVE || !(USBIN & USBIDLE)) {
+                BUS_ACTIVE = 0;
+                BUS_IDLE = 0;
+            }else if(++BUS_IDLE >= OG_SUSPEND_MS && eeprom_is_ready() && !BOOT_REQUEST) {
+                cli();
+                BUS_ACTIVE = 0;
+                sei();
+                suspend();
+            }
+        }
+
+        // Counting the keys which went down since the previous loop and following the order of the d-pad presses.
+        scanRead(&frame);
+        if(frame.bmask & ~prev) settingsCountPresses(frame.bmask & ~prev);
+        socdTrack(frame.bmask);
+        remapChord(frame.bmask);
+        prev = frame.bmask;
+
+        eeJournalTask();                   // Writing the changed settings in the background.
 
-    if(ic.raw > 18) ic.raw = 0;
+        // Pending settings are lost on restart, so the bootloader waits for the journal as well.
+        if(BOOT_REQUEST && (usbTxLen & 0x10) && !eeJournalBusy()) bootloaderEnter();
+
+        idle();
+    }
 }
 
 /* 
- * Sets an interrupt for the PB0 pin. 
+ * Sets an interrupt for the D- line. 
  * 
- * INT0 is reserved for the V-USB use. The PCINT[5..0] would cause this interrupt.
- * This handler detects a keypress obtained from the key matrix and iterates over each key to
- * define which key was pressed. All pressed keys are then saved into a mask and send via USB
- * connection.
+ * INT0 is reserved for the V-USB use. D- is the only pin change source, see hal.h. Any edge on D- marks the bus as active.
+ * The interrupt may nest, so it never delays the V-USB interrupt. The keys are read by the scan, see scan.c.
  * */
-ISR(PCINT0_vect) {
-    RPTR->bmask = (PORTB & 1) << ic.DIGITAL;      // Marking the value in the button mask. This way several keys can be pressed in one loop.
+ISR(OG_HAL_PCINT_vect, ISR_NOBLOCK) {
+    BUS_ACTIVE = 1;
+}
+
+// Counts the clock ticks, see clock.h. The interrupt may nest, so it never delays the V-USB interrupt.
+ISR(OG_HAL_TIMER_vect, ISR_NOBLOCK) {
+    CLOCK_TICKS++;
 }
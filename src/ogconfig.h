@@ -0,0 +1,336 @@
+/*
+ *  Configuration header for 'Open Game Pad' firmware features.
+ *
+ *  This file collects the compile time switches of the firmware in the same manner as usbconfig.h does for V-USB. Each
+ *  value is followed by the description of what it changes. Everything here can also be overridden from the command line
+ *  with -D, so board variants do not have to fork this file.
+ * */
+
+#ifndef __OGCONFIG_H__
+#define __OGCONFIG_H__
+
+/* ----------------------------- Input Layout ------------------------------ */
+
+#define OG_BOARD_CLASSIC            0
+#define OG_BOARD_ARCADE             1
+#ifndef OG_BOARD
+#define OG_BOARD                    OG_BOARD_CLASSIC
+#endif
+/* Board the firmware is built for. The board sets the defaults of the
+ * topology below and its scan decode table:
+ * OG_BOARD_CLASSIC: the original pad, one 74HC163, a 74HC4052 for four axes
+ *                   and four key columns, a 74HC595 for the key rows.
+ * OG_BOARD_ARCADE:  32 keys and 8 axes for sticks and cockpits. A second
+ *                   counter stage gives 32 states, a 74HC4051 selects the
+ *                   axes and the key of each state is decoded on the board.
+ *                   Its tables and counters need the RAM of a bigger MCU.
+ * Each value can still be overridden on its own.
+ */
+#if OG_BOARD == OG_BOARD_ARCADE
+#ifndef OG_BUTTONS
+#define OG_BUTTONS                  32
+#endif
+#ifndef OG_AXES
+#define OG_AXES                     8
+#endif
+#ifndef OG_COUNTER_BITS
+#define OG_COUNTER_BITS             5
+#endif
+#ifndef OG_MUX_CHANNELS
+#define OG_MUX_CHANNELS             8
+#endif
+#ifndef OG_SCAN_STATES
+#define OG_SCAN_STATES              32
+#endif
+#ifndef OG_SCAN_TABLE
+#define OG_SCAN_TABLE               "scanarcade.h"
+#endif
+#ifndef OG_EE_SLOT_SIZE
+#define OG_EE_SLOT_SIZE             64
+#endif
+#ifndef OG_SCAN_SYNC
+#define OG_SCAN_SYNC                0
+#endif
+#endif
+
+#ifndef OG_BUTTONS
+#define OG_BUTTONS                  18
+#endif
+/* Amount of digital keys read from the switch matrix. Each key takes one bit
+ * of the button mask, at most 32. The scan decode table must read every key,
+ * the classic board has 18: four rows by four columns and the two stick
+ * clicks on the fifth row.
+ */
+#ifndef OG_AXES
+#define OG_AXES                     4
+#endif
+/* Amount of analog axes read through the analog multiplexer. Two COM-09032
+ * joysticks give four axes. Axes are paired into joysticks, see stick.h.
+ */
+#ifndef OG_COUNTER_BITS
+#define OG_COUNTER_BITS             4
+#endif
+/* Width of the scan counter. */
+#ifndef OG_MUX_CHANNELS
+#define OG_MUX_CHANNELS             4
+#endif
+/* Channels of the analog multiplexer, selected by the low counter bits. */
+#ifndef OG_SCAN_STATES
+#define OG_SCAN_STATES              20
+#endif
+/* Counter states in one scan period, after which the channels and the key
+ * rows repeat. The classic row latch walks five rows of four states, so its
+ * period is 20 states and the counter runs 4 states further each period.
+ * A multiple of OG_MUX_CHANNELS, at most 64.
+ */
+
+/* --------------------------------- Scan ---------------------------------- */
+
+#ifndef OG_SCAN_DISCARD
+#define OG_SCAN_DISCARD             1
+#endif
+/* Set to 1 to throw away the first conversion after the multiplexer
+ * switched. Each counter state then takes two scan steps: the key is read
+ * while the multiplexer settles and the axis is sampled in the second step.
+ * Set to 0 to read the key and sample the axis in the same step, which
+ * halves the scan period and the sample age, but the axes may catch the
+ * multiplexer still settling. See scan.h for the timing.
+ */
+#ifndef OG_SCAN_TABLE
+#define OG_SCAN_TABLE               "scantable.h"
+#endif
+/* Header with the decode table of the board, see scan.h. It tells for every
+ * step which axis is sampled and which key is read. A board with rerouted
+ * multiplexer inputs or key matrix only needs its own table.
+ */
+#ifndef OG_SCAN_SLOW_MS
+#define OG_SCAN_SLOW_MS             2
+#endif
+/* Milliseconds between scan periods while the pad is at rest. The scan runs
+ * back to back for OG_SCAN_HOLD_MS after every change and then only once in
+ * this time, which saves most of the scan interrupts and the ADC noise. A
+ * press at rest is seen up to this much later. Set to 0 to always scan at
+ * the full rate.
+ */
+#ifndef OG_SCAN_HOLD_MS
+#define OG_SCAN_HOLD_MS             500
+#endif
+/* Milliseconds the scan stays at the full rate after the last change. */
+#ifndef OG_SCAN_DELTA
+#define OG_SCAN_DELTA               3
+#endif
+/* Smallest change of a raw axis reading that counts as a change for the
+ * scan rate. Smaller changes are noise. Any key change always counts.
+ */
+#ifndef OG_SCAN_SYNC
+#define OG_SCAN_SYNC                1
+#endif
+/* Set to 1 to check the scan against a reference position of the matrix
+ * that is tied high, see OG_SCAN_REF in scan.h. A missed or doubled clock
+ * edge is then noticed within one period and the counter is found again
+ * after one more, or two while keys are held. The stock boards have no signal
+ * that tells the counter states apart while no key is pressed, so the
+ * reference needs a diode on the board. The classic board reads it on the
+ * free position Y5/X3 and loses no key, a board without the diode turns the
+ * check off after the first period and only pays one compare per step.
+ * The arcade board has no free position, the reference takes key 31 there
+ * and it is off by default.
+ */
+
+/* ------------------------------ Axis Filter ------------------------------ */
+
+#ifndef OG_FILTER_REST
+#define OG_FILTER_REST              4
+#endif
+/* Default shift of the axis filter at rest, see filter.h. Each millisecond
+ * the output moves by 2^-OG_FILTER_REST of its distance to the raw reading,
+ * 4 gives a time constant of 16 ms. 0 turns the filter off. Tunable per axis
+ * at runtime through the TUNING record.
+ */
+#ifndef OG_FILTER_SPEED
+#define OG_FILTER_SPEED             1
+#endif
+/* Default speed setting of the axis filter. The shift drops by one for
+ * every 2^OG_FILTER_SPEED counts between the raw reading and the output, so
+ * with the defaults a distance of 8 counts passes unfiltered.
+ */
+#ifndef OG_FILTER_BAND
+#define OG_FILTER_BAND              0xFF
+#endif
+/* Default change band of the axes. The reports follow an axis only once it
+ * moved more than this many counts away from the reported value, so noise
+ * alone does not cause reports. 0xFF follows the measured noise floor of
+ * each axis, 0 reports every change of the filtered value.
+ */
+
+/* ---------------------------- Center Tracking ---------------------------- */
+
+#ifndef OG_CENTER_TRACK
+#define OG_CENTER_TRACK             1
+#endif
+/* Set to 1 to follow the drift of the joystick centers while the pad
+ * rests, see center.h.
+ */
+#ifndef OG_CENTER_QUIET_MS
+#define OG_CENTER_QUIET_MS          2000
+#endif
+/* Milliseconds without a key change before the centers are tracked. */
+#ifndef OG_CENTER_NOISE
+#define OG_CENTER_NOISE             2
+#endif
+/* Largest distance of the raw reading from the filtered one, in counts, at
+ * which an axis still counts as resting.
+ */
+#ifndef OG_CENTER_RANGE
+#define OG_CENTER_RANGE             16
+#endif
+/* Largest distance from the current center, in counts, that is taken for
+ * drift. A stick held further out is never tracked. The automatic change
+ * band of the filter measures the noise within the same range.
+ */
+#ifndef OG_CENTER_SHIFT
+#define OG_CENTER_SHIFT             13
+#endif
+/* The center moves by 2^-OG_CENTER_SHIFT of its distance to the resting
+ * reading each millisecond, so the time constant is 2^OG_CENTER_SHIFT ms of
+ * rest: 13 gives 8.2 s. A briefly held small tilt is not taken for the
+ * center, a constant 5 count offset is reported as the center after 19 s
+ * of tracking, 22 s of rest with OG_CENTER_QUIET_MS. The tracked center
+ * keeps 16 fractional bits, so it settles within 2^(OG_CENTER_SHIFT - 16)
+ * counts. At most 14.
+ */
+#ifndef OG_CENTER_SAVE_MIN
+#define OG_CENTER_SAVE_MIN          10
+#endif
+/* Minutes between two EEPROM writes of a moved center. The tracked center
+ * is used right away, a power loss only loses the latest drift.
+ */
+
+/* -------------------------------- Sticks --------------------------------- */
+
+#ifndef OG_STICK_DEADZONE
+#define OG_STICK_DEADZONE           8
+#endif
+/* Default radial deadzone of each joystick, in counts of the centered axes.
+ * Tunable per joystick at runtime through the TUNING record, see stick.h.
+ */
+#ifndef OG_STICK_OUTER
+#define OG_STICK_OUTER              120
+#endif
+/* Default radius of the outer ring. Anything beyond it is the full
+ * deflection, so every stick reaches 127 despite its tolerances. Values
+ * above 191 are treated as 191.
+ */
+#ifndef OG_STICK_CURVE
+#define OG_STICK_CURVE              "stickcurve.h"
+#endif
+/* Header with the custom response curve, see stickcurve.h. */
+
+/* ------------------------------- D-pad SOCD ------------------------------ */
+
+#ifndef OG_SOCD_VERTICAL
+#define OG_SOCD_VERTICAL            0
+#endif
+/* Default handling of up and down pressed together, one of OG_SOCD_* in
+ * socd.h: 0 passes both, 1 neutral, 2 last input wins, 3 first input wins,
+ * 4 up wins. Tunable at runtime through the TUNING record.
+ */
+#ifndef OG_SOCD_HORIZONTAL
+#define OG_SOCD_HORIZONTAL          0
+#endif
+/* Default handling of right and left pressed together, same values. */
+
+/* ---------------------------- Button Profiles ---------------------------- */
+
+#ifndef OG_PROFILES
+#define OG_PROFILES                 2
+#endif
+/* Amount of button maps, 1 to 4. Each map is its own journal record, the
+ * active one is chosen with the OG_RQ_PROFILE request or the chord below.
+ */
+#ifndef OG_PROFILE_CHORD
+#define OG_PROFILE_CHORD            0
+#endif
+/* Mask of physical keys which switch to the next profile when pressed
+ * together. 0 disables the chord.
+ */
+
+/* ------------------------------ USB Report ------------------------------- */
+
+#ifndef OG_EDGE_TIMES
+#define OG_EDGE_TIMES               0
+#endif
+/* Set to 1 to time stamp the last press and release of every key in the
+ * scan and to answer the OG_RQ_TIMING request with them, see ogpad.h. Takes
+ * 4 bytes of RAM per key, which the ATtiny85 does not have to spare, so it
+ * only builds for parts with 1 KB of RAM or more.
+ */
+
+#ifndef OG_REPORT_COMPACT
+#define OG_REPORT_COMPACT           0
+#endif
+/* Set to 1 to send the smallest report: the d-pad keys become a HID hat
+ * switch and the button bits are padded only to the next byte, which takes
+ * the default report from 8 to 7 bytes. The d-pad must be wired to keys 0
+ * to 3 in the order up, right, down, left. Host mappings which expect the
+ * d-pad as buttons have to be adjusted.
+ */
+
+/* ------------------------------ Power Saving ----------------------------- */
+
+#ifndef OG_IDLE_SLEEP
+#define OG_IDLE_SLEEP               0
+#endif
+/* Set to 1 to let the CPU sleep in idle mode whenever the main loop has
+ * nothing to do. Any interrupt wakes it, so the USB handling should not be
+ * delayed. Off until the supply current of a pad and the usbPoll() latency
+ * were measured with it: 'make sim' prints the share of cycles asleep and
+ * the longest awake gap between two usbPoll() calls for either setting.
+ */
+
+#ifndef OG_SUSPEND_MS
+#define OG_SUSPEND_MS               3
+#endif
+/* Milliseconds of the idle J state on the bus after which the pad
+ * suspends. The host sends a keep-alive every millisecond, so 3 ms is the
+ * USB specification value. A bus reset holds SE0 instead and never
+ * suspends the pad.
+ */
+#ifndef OG_WAKE_SCAN
+#define OG_WAKE_SCAN                WDTO_30MS
+#endif
+/* Watchdog period of the key scan while suspended, if the host allows
+ * remote wakeup. A pressed key wakes the host after at most this time plus
+ * about 1 ms for the oscillator start-up. Shorter periods draw more current
+ * while suspended.
+ */
+
+/* ---------------------------- EEPROM Journal ----------------------------- */
+
+#ifndef OG_EE_SIZE
+#define OG_EE_SIZE                  512
+#endif
+/* Size of the EEPROM in bytes. The whole EEPROM is used by the journal. */
+#ifndef OG_EE_SLOT_SIZE
+#define OG_EE_SLOT_SIZE             32
+#endif
+/* Size of one journal slot. A slot holds a tag byte, a sequence byte, a size
+ * byte, the payload and a CRC-16. Must be a power of two that divides OG_EE_SIZE.
+ */
+#ifndef OG_EE_COUNTER_SAVE_PRESSES
+#define OG_EE_COUNTER_SAVE_PRESSES  256
+#endif
+/* Lifetime press counters are written back to the EEPROM after this many
+ * new presses were counted. Lower values lose less counts on power loss, but
+ * wear the EEPROM faster.
+ */
+#ifndef OG_EE_REFRESH_AGE
+#define OG_EE_REFRESH_AGE           64
+#endif
+/* Records which were not saved for this many journal writes are rewritten
+ * to keep every live record inside the window where the 8-bit sequence
+ * numbers can still be compared. Must be lower than 128 - OG_EE_SIZE /
+ * OG_EE_SLOT_SIZE.
+ */
+
+#endif
@@ -7,33 +7,94 @@
 
 #include <stdint.h>
 
+#include "../boot/bootloader.h"
+#include "report.h"
+
+
+/*
+ *  Scanned state of the inputs.
+ *
+ *  Copied from the scan, see scan.h. Every report is packed from it.
+ * */
+typedef struct {
+    // Button mask for all keys. Bit N is the physical key N.
+    uint32_t bmask;
+    // Keys which went down since their latch was last cleared, even if they are already released again.
+    uint32_t pressed;
+    // The joystick axises in the order of the multiplexer inputs, as raw 8-bit ADC readings.
+    uint8_t axes[OG_AXES];
+} frame_t;
 
 /* 
  *  Custom structure that describes data obtained from the game pad.
  *
- *  This report is then sent to the host device via USB protocol. The report format must be compatible with the HID report.
+ *  This report is then sent to the host device via USB protocol. The members are generated from the report table in
+ *  report.h, which also generates the HID report descriptor, so both always describe the same bits:
+ *  - hat: the d-pad as a hat switch, only in the compact layout.
+ *  - bmask: button mask for all keys. Each bit corresponds to a key value. The compact layout leaves out the d-pad.
+ *  - joyax: the joystick axises in the following order: left HORIZONTAL, left VERTICAL, right HORIZONTAL, right VERTICAL.
  * */
 typedef struct {
-    // Button mask for all 18 keys. Each bit corresponds to a key value. Overflowing values will be always ignored.
-    uint32_t bmask;
-    // The joystick axises are defined in the following order: left HORIZONTAL, left VERTICAL, right HORIZONTAL, right VERTICAL.
-    int8_t joyax[4];
+    OG_REPORT(OG_STRUCT_BUTTONS, OG_STRUCT_PAD, OG_STRUCT_AXES, OG_STRUCT_HAT)
 } __attribute__((packed)) report_t;
 
-/* 
- *  Input Counter Byte. Counts which input (ANALOG/DIGITAL) is currently in
+_Static_assert(OG_REPORT_BITS % 8 == 0, "report must end on a byte boundary");
+_Static_assert(sizeof(report_t) == OG_REPORT_SIZE, "report structure does not match the report table");
+// Longer reports are sent in several packets of 8 bytes, the last one must be shorter to end the transfer.
+_Static_assert(OG_REPORT_SIZE <= 8 || OG_REPORT_SIZE % 8, "long reports must not fill their last packet");
+
+/*
+ *  Vendor requests.
  *
- *  Custom union type that allows for using one 8-bit variable to manipulate with indexes of smaller sizes.
- *  This union allows to manipulate the data without bitwise operation, making it a better readibility choice. 
- *  Note that ANALOG and DIGITAL fields are READONLY must not never be used to write new data. */
-typedef union {
-    uint8_t raw;            // Full byte with five last bits always unused.
-    
-    uint8_t ANALOG: 2;      // Two lower bits for 4 analog inputs.
-    uint8_t DIGITAL: 5;     // 5 lower bits for 18 digital inputs encoded in a 5-bit value MSB first. 
-} inputCounter;
+ *  OG_RQ_CONFIG_READ (device to host) and OG_RQ_CONFIG_WRITE (host to device) transfer the configuration blob described
+ *  in settings.h. wLength is the amount of bytes to transfer and must not be bigger than 254.
+ *  OG_RQ_BOOTLOADER (no data) restarts the pad into the HID bootloader once the request is acknowledged. Ignored on parts
+ *  without the bootloader, see hal.h.
+ *  OG_RQ_STATS (device to host) returns stats_t.
+ *  OG_RQ_TIMING (device to host) returns timing_t, if the firmware is built with OG_EDGE_TIMES.
+ *  OG_RQ_PROFILE (no data) activates the button map given in the low byte of wValue and stores the choice.
+ * */
+#define OG_RQ_CONFIG_READ       1
+#define OG_RQ_CONFIG_WRITE      2
+#define OG_RQ_BOOTLOADER        BOOT_RQ_ENTER
+#define OG_RQ_STATS             4
+#define OG_RQ_TIMING            5
+#define OG_RQ_PROFILE           6
+
+/*
+ *  Runtime statistics, collected since power up.
+ *
+ *  Times are in clock timer counts (3.88 us on the ATtiny85), see clock.h.
+ * */
+typedef struct {
+    uint16_t suspends;              // Amount of times the pad was suspended.
+    uint16_t resumeLatency;         // Time from the last wake-up to the first report sent after it.
+    uint16_t remoteWakeups;         // Amount of times a key press woke the host.
+    uint16_t resyncs;               // Amount of times the scan found the counter out of step, see scan.h.
+    uint32_t fastMs;                // Milliseconds scanned at the full rate.
+    uint32_t slowMs;                // Milliseconds scanned at the rest rate, see OG_SCAN_SLOW_MS.
+    uint16_t stackFree;             // Least free stack in bytes, taken when the request is answered, see stack.h.
+} __attribute__((packed)) stats_t;
+
+/*
+ *  Time stamps of the last press and release of each key.
+ *
+ *  All times are clockStamp() values in clock timer counts (3.88 us on the ATtiny85), see clock.h. 'now' is taken when
+ *  the request is answered, so now - press[N] is the time since key N went down. The counts wrap after 256 ticks of the
+ *  clock (254 ms on the ATtiny85, where the difference wraps with them), older edges can not be told apart.
+ *
+ *  Each entry is copied with interrupts off as its chunk is sent, so it is never half written. An edge during the
+ *  transfer may still show in an entry sent after it, that entry is then newer than 'now'.
+ * */
+typedef struct {
+    uint16_t now;
+    uint16_t press[OG_BUTTONS + 1];             // The last entry belongs to the scan reference.
+    uint16_t release[OG_BUTTONS + 1];
+} timing_t;
 
 // Game Pad report holds the current pressed keys and joystick axises derivatives.
-static report_t REPORT;
+extern report_t REPORT;
+// Runtime statistics.
+extern stats_t STATS;
 
 #endif
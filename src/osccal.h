@@ -0,0 +1,52 @@
+/* 
+ *  RC oscillator calibration for 'Open Game Pad'.
+ *
+ *  The ATtiny85 runs from its internal PLL clock, which has to be tuned to 16.5 MHz for V-USB. The calibration measures
+ *  the length of the USB frame with different OSCCAL values. Shared by the firmware and the bootloader.
+ * */
+
+#ifndef __OSCCAL_H__
+#define __OSCCAL_H__
+
+#include<avr/interrupt.h>
+#include<avr/io.h>
+
+#include "../usbdrv/usbdrv.h"
+
+#define abs(x) ((x) > 0 ? (x) : (-x))
+
+// Calibrates the RC oscillator to 16.5 MHz speeds. Returns the value written to OSCCAL.
+static inline uchar osccalCalibrate(void) {
+    int frameLength, targetLength = (unsigned)(1499 * (double)F_CPU / 10.5e6 + 0.5);
+    int bestDeviation = 9999;
+    uchar trialCal, bestCal = OSCCAL, step, region;
+
+    // do a binary search in regions 0-127 and 128-255 to get optimum OSCCAL
+    for(region = 0; region <= 1; region++) {
+        frameLength = 0;
+        trialCal = (region == 0) ? 0 : 128;
+        
+        for(step = 64; step > 0; step >>= 1) { 
+            if(frameLength < targetLength) // true for initial iteration
+                trialCal += step; // frequency too low
+            else
+                trialCal -= step; // frequency too high
+                
+            OSCCAL = trialCal;
+
+            cli();
+            frameLength = usbMeasureFrameLength();
+            sei();
+
+            if(abs(frameLength-targetLength) < bestDeviation) {
+                bestCal = trialCal; // new optimum found
+                bestDeviation = abs(frameLength -targetLength);
+            }
+        }
+    }
+
+    OSCCAL = bestCal;
+    return bestCal;
+}
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ *  Button remapping of 'Open Game Pad'.
+ * */
+
+#include "remap.h"
+#include "settings.h"
+
+// Set while the active map leaves every key on its own bit.
+static uint8_t REMAP_PLAIN;
+#if OG_PROFILE_CHORD
+// Whether the chord was down on the previous call.
+static uint8_t CHORD;
+#endif
+
+void remapBuild(void) {
+    if(TUNING.profile >= OG_PROFILES) TUNING.profile = 0;
+    REMAP_PLAIN = 1;
+    for(uint8_t key = 0; key < OG_BUTTONS; key++) {
+        if(BMAP[TUNING.profile][key] != key) REMAP_PLAIN = 0;
+    }
+}
+
+void remapProfile(uint8_t profile) {
+    if(profile >= OG_PROFILES || profile == TUNING.profile) return;
+    TUNING.profile = profile;
+    remapBuild();
+    eeJournalSave(OG_TAG_TUNING);
+}
+
+uint32_t remapApply(uint32_t bmask) {
+    const uint8_t *map = BMAP[TUNING.profile];
+    uint32_t out = 0;
+    uint8_t *bytes = (uint8_t *) &out;
+
+    if(REMAP_PLAIN) return bmask;
+    // Keys mapped beyond the report are dropped. The loop ends with the highest pressed key.
+    for(uint8_t key = 0; bmask && key < OG_BUTTONS; key++, bmask >>= 1) {
+        if((bmask & 1) && map[key] < 32) bytes[map[key] >> 3] |= 1 << (map[key] & 7);
+    }
+
+    return out;
+}
+
+void remapChord(uint32_t bmask) {
+#if OG_PROFILE_CHORD
+    uint8_t down = (bmask & OG_PROFILE_CHORD) == OG_PROFILE_CHORD;
+
+    if(down && !CHORD) remapProfile(TUNING.profile + 1 < OG_PROFILES ? TUNING.profile + 1 : 0);
+    CHORD = down;
+#endif
+}
@@ -0,0 +1,24 @@
+/*
+ *  Button remapping of 'Open Game Pad'.
+ *
+ *  The button map of the active profile (see BMAP in settings.h) is checked once, whenever the map or the profile changes.
+ *  A map that leaves every key on its own bit, the default, passes the mask through untouched. Otherwise each pressed key
+ *  sets the report bit it is mapped to, one loop over the keys once per report. Lookup tables would save the loop, but
+ *  even pair tables take 12 bytes of RAM per key pair, which the ATtiny85 can not spare next to the stack.
+ * */
+
+#ifndef __REMAP_H__
+#define __REMAP_H__
+
+#include <stdint.h>
+
+/* Checks the map of the active profile. Must be called whenever the map changes. */
+void remapBuild(void);
+/* Switches to 'profile' and stores the choice. Ignored for unknown profiles. */
+void remapProfile(uint8_t profile);
+/* Returns the report bits of the physical keys in 'bmask'. */
+uint32_t remapApply(uint32_t bmask);
+/* Switches to the next profile when the chord is pressed. Must be called with every new button mask. */
+void remapChord(uint32_t bmask);
+
+#endif
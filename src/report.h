@@ -0,0 +1,130 @@
+/*
+ *  Input report layout of 'Open Game Pad'.
+ *
+ *  OG_REPORT is the only place where the report is described. The HID report descriptor, the report_t structure and the
+ *  descriptor length for usbconfig.h are all generated from it, so they can not drift apart. Fields are listed in the
+ *  order of transmission, the first field starts at bit 0 of the first byte.
+ *
+ *  This header is included by usbconfig.h and therefore also by the assembler. Everything above the C section must stay
+ *  plain preprocessor arithmetic.
+ * */
+
+#ifndef __REPORT_H__
+#define __REPORT_H__
+
+#include "ogconfig.h"
+
+/*
+ *  Report table.
+ *
+ *  Each field is one of:
+ *  BUTTONS(name, count)    'count' one bit buttons, named Button 1 to Button 'count' in the order of the bits.
+ *  PAD(bits)               'bits' constant bits, ignored by the host.
+ *  AXES(name, count)       'count' signed 8-bit axes with the usages X, Y, Z, Rx, Ry, Rz, Slider and Dial in this order.
+ *  HAT(name)               4-bit hat switch, 0 is up and each step turns by 45 degrees clockwise, 8 is released.
+ *
+ *  The full layout keeps the button mask as it is scanned. The compact layout (OG_REPORT_COMPACT) replaces the four
+ *  d-pad keys with a hat switch and pads only up to the next byte.
+ * */
+#if OG_REPORT_COMPACT
+#define OG_REPORT(BUTTONS, PAD, AXES, HAT)  \
+    HAT(hat)                                \
+    BUTTONS(bmask, OG_BUTTONS - 4)          \
+    OG_REPORT_ALIGN(PAD)                    \
+    AXES(joyax, OG_AXES)
+// The hat and the buttons take OG_BUTTONS bits together. A padding field is only added when they do not fill the bytes.
+#if OG_BUTTONS % 8
+#define OG_REPORT_ALIGN(PAD)                PAD(8 - OG_BUTTONS % 8)
+#else
+#define OG_REPORT_ALIGN(PAD)
+#endif
+#else
+#define OG_REPORT(BUTTONS, PAD, AXES, HAT)  \
+    BUTTONS(bmask, OG_BUTTONS)              \
+    OG_REPORT_FILL(PAD)                     \
+    AXES(joyax, OG_AXES)
+// The button mask always takes 32 bits. A padding field is only added when the buttons do not fill them.
+#if OG_BUTTONS < 32
+#define OG_REPORT_FILL(PAD)                 PAD(32 - OG_BUTTONS)
+#else
+#define OG_REPORT_FILL(PAD)
+#endif
+#endif
+
+// Size of each field in bits.
+#define OG_BITS_BUTTONS(name, n)        + (n)
+#define OG_BITS_PAD(n)                  + (n)
+#define OG_BITS_AXES(name, n)           + 8 * (n)
+#define OG_BITS_HAT(name)               + 4
+// Size of the descriptor items of each field in bytes.
+#define OG_DLEN_BUTTONS(name, n)        + 16
+#define OG_DLEN_PAD(n)                  + 6
+#define OG_DLEN_AXES(name, n)           + 16
+#define OG_DLEN_HAT(name)               + 23
+
+// Size of the report in bits and in bytes.
+#define OG_REPORT_BITS                  (0 OG_REPORT(OG_BITS_BUTTONS, OG_BITS_PAD, OG_BITS_AXES, OG_BITS_HAT))
+#define OG_REPORT_SIZE                  (OG_REPORT_BITS / 8)
+// Length of the report descriptor. The collections around the fields take 10 bytes.
+#define OG_REPORT_DESCRIPTOR_LENGTH     (10 OG_REPORT(OG_DLEN_BUTTONS, OG_DLEN_PAD, OG_DLEN_AXES, OG_DLEN_HAT))
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+// Descriptor items of each field.
+#define OG_DESC_BUTTONS(name, n)                                        \
+    0x05, 0x09,                    /*     USAGE_PAGE (Button) */        \
+    0x19, 0x01,                    /*     USAGE_MINIMUM (Button 1) */   \
+    0x29, (n),                     /*     USAGE_MAXIMUM (Button n) */   \
+    0x15, 0x00,                    /*     LOGICAL_MINIMUM (0) */        \
+    0x25, 0x01,                    /*     LOGICAL_MAXIMUM (1) */        \
+    0x95, (n),                     /*     REPORT_COUNT (n) */           \
+    0x75, 0x01,                    /*     REPORT_SIZE (1) */            \
+    0x81, 0x02,                    /*     INPUT (Data,Var,Abs) */
+#define OG_DESC_PAD(n)                                                  \
+    0x95, 0x01,                    /*     REPORT_COUNT (1) */           \
+    0x75, (n),                     /*     REPORT_SIZE (n) */            \
+    0x81, 0x03,                    /*     INPUT (Cnst,Var,Abs) */
+#define OG_DESC_AXES(name, n)                                           \
+    0x05, 0x01,                    /*     USAGE_PAGE (Generic Desktop) */ \
+    0x19, 0x30,                    /*     USAGE_MINIMUM (X) */          \
+    0x29, 0x30 + (n) - 1,          /*     USAGE_MAXIMUM */              \
+    0x15, 0x81,                    /*     LOGICAL_MINIMUM (-127) */     \
+    0x25, 0x7F,                    /*     LOGICAL_MAXIMUM (127) */      \
+    0x75, 0x08,                    /*     REPORT_SIZE (8) */            \
+    0x95, (n),                     /*     REPORT_COUNT (n) */           \
+    0x81, 0x02,                    /*     INPUT (Data,Var,Abs) */
+#define OG_DESC_HAT(name)                                               \
+    0x05, 0x01,                    /*     USAGE_PAGE (Generic Desktop) */ \
+    0x09, 0x39,                    /*     USAGE (Hat switch) */         \
+    0x15, 0x00,                    /*     LOGICAL_MINIMUM (0) */        \
+    0x25, 0x07,                    /*     LOGICAL_MAXIMUM (7) */        \
+    0x35, 0x00,                    /*     PHYSICAL_MINIMUM (0) */       \
+    0x46, 0x3B, 0x01,              /*     PHYSICAL_MAXIMUM (315) */     \
+    0x65, 0x14,                    /*     UNIT (Eng Rot:Angular Pos) */ \
+    0x75, 0x04,                    /*     REPORT_SIZE (4) */            \
+    0x95, 0x01,                    /*     REPORT_COUNT (1) */           \
+    0x81, 0x42,                    /*     INPUT (Data,Var,Abs,Null) */  \
+    0x65, 0x00,                    /*     UNIT (None) */
+
+// Members of report_t generated for each field. Bit fields are allocated from the lowest bit, the same as HID does.
+#define OG_STRUCT_BUTTONS(name, n)      uint32_t name : (n);
+#define OG_STRUCT_PAD(n)                uint32_t : (n);
+#define OG_STRUCT_AXES(name, n)         int8_t name[n];
+#define OG_STRUCT_HAT(name)             uint8_t name : 4;
+
+// Initializer of the whole report descriptor.
+#define OG_REPORT_DESCRIPTOR {                                          \
+    0x05, 0x01,                    /* USAGE_PAGE (Generic Desktop) */   \
+    0x09, 0x05,                    /* USAGE (Gamepad) */                \
+    0xA1, 0x01,                    /* COLLECTION (Application) */       \
+    0xA1, 0x00,                    /*   COLLECTION (Physical) */        \
+    OG_REPORT(OG_DESC_BUTTONS, OG_DESC_PAD, OG_DESC_AXES, OG_DESC_HAT)  \
+    0xC0,                          /*   END_COLLECTION */               \
+    0xC0                           /* END_COLLECTION */                 \
+}
+
+#endif
+
+#endif
@@ -0,0 +1,264 @@
+/*
+ *  Input scan of 'Open Game Pad'.
+ *
+ *  The ADC interrupt reads the decode table entry of the step that just finished, clocks the counter, starts the next
+ *  conversion and stores DIN and the sample where the entry says. Every step takes the same path, the table decides
+ *  whether the sample is kept and which key bit is written. The lines are reached through the backend in hal.h.
+ * */
+
+#include<avr/pgmspace.h>
+#include<avr/interrupt.h>
+#include<util/delay.h>
+
+#include "clock.h"
+#include "scan.h"
+#include OG_SCAN_TABLE
+
+_Static_assert(sizeof(SCAN_TABLE) / sizeof(SCAN_TABLE[0]) == OG_SCAN_STEPS, "scan table must cover every step");
+_Static_assert(OG_BUTTONS <= 32, "button mask holds at most 32 keys");
+
+// Key bits in the order of the button mask, bit N of the mask is bit N % 8 of byte N / 8. The last byte holds the reference.
+static volatile uint8_t KEYS[OG_SCAN_REF_BYTE + 1];
+// Press latches in the same order. A key bit is set on every press and stays set until scanLatchClear().
+static volatile uint8_t LATCH[OG_SCAN_REF_BYTE + 1];
+// Raw axis samples. The last one is the sink of the discarded conversions.
+static volatile uint8_t AXES[OG_AXES + 1];
+// Step whose conversion is in progress.
+static volatile uint8_t STEP;
+volatile uint8_t SCAN_NEW = 1;
+#if OG_EDGE_TIMES
+// The default tiny85 build leaves about 90 bytes of its 512 for the stack, the time stamps need 4 bytes per key.
+_Static_assert(RAMEND - RAMSTART + 1 >= 1024, "edge time stamps do not fit into the RAM, see OG_EDGE_TIMES");
+timing_t TIMING;
+#endif
+// Set while the scan runs at the rest rate. The interrupt then stops at the end of each period and sets SCAN_PAUSED.
+static volatile uint8_t SCAN_SLOW;
+static volatile uint8_t SCAN_PAUSED;
+#if OG_SCAN_SLOW_MS
+// Keys and axes last seen as a change, milliseconds left at the full rate and until the next period at rest.
+static uint32_t PACE_KEYS;
+static uint8_t PACE_AXES[OG_AXES];
+static uint16_t PACE_HOLD;
+static uint8_t PACE_WAIT;
+#endif
+#ifdef OG_SCAN_REF_STEP
+// Last step of the reference. With OG_SCAN_DISCARD DIN still shows it during the axis step of its counter state.
+#define SYNC_END            ((OG_SCAN_REF_STEP + OG_SCAN_DISCARD) % OG_SCAN_STEPS)
+// Steps left of the search for the reference. Zero while the scan is in step.
+static uint8_t SYNC_HUNT;
+// Step starting a run of high readings closest to the reference in the current and in the previous search period,
+// OG_SCAN_STEPS if there was none.
+static uint8_t SYNC_HIT;
+static uint8_t SYNC_LAST;
+// SYNC_ARMED until a search finds no high reading at all, SYNC_MANY once the current search saw a second run and
+// SYNC_HIGH while the previous step read high.
+#define SYNC_ARMED          1
+#define SYNC_MANY           2
+#define SYNC_HIGH           4
+static uint8_t SYNC_FLAGS = SYNC_ARMED;
+#else
+#define SYNC_HUNT           0
+#endif
+
+void scanStart(void) {
+    SCAN_PAUSED = 0;
+    halAdcInit();
+}
+
+void scanStop(void) {
+    halAdcStop();
+}
+
+void scanLatchClear(uint32_t mask) {
+    uint8_t *clear = (uint8_t *) &mask;
+
+    cli();
+    for(uint8_t i = 0; i < 4; i++) LATCH[i] &= ~clear[i];
+    sei();
+}
+
+void scanRead(frame_t *frame) {
+    uint8_t *bmask = (uint8_t *) &frame->bmask, *pressed = (uint8_t *) &frame->pressed;
+
+    cli();
+    for(uint8_t i = 0; i < 4; i++) {
+        bmask[i] = KEYS[i];
+        pressed[i] = LATCH[i];
+    }
+    for(uint8_t i = 0; i < OG_AXES; i++) frame->axes[i] = AXES[i];
+    sei();
+}
+
+#if OG_EDGE_TIMES
+// The scan writes the time stamps from its interrupt, so each one is read with interrupts off and never half written.
+void scanTimes(uint8_t *data, uint8_t pos, uint8_t len) {
+    const uint16_t *at = (const uint16_t *) ((const uint8_t *) &TIMING + pos);
+
+    for(uint8_t i = 0; i < len; i += 2) {
+        cli();
+        uint16_t t = *at++;
+        sei();
+        data[i] = t;
+        if(i + 1 < len) data[i + 1] = t >> 8;
+    }
+}
+#endif
+
+/*
+ * Axis changes below OG_SCAN_DELTA are compared against the frame of the last change, so a slow drift still counts once
+ * it adds up. The rest rate starts a period only when the previous one stopped, a period is never cut short.
+ * */
+void scanPace(void) {
+#if OG_SCAN_SLOW_MS
+    frame_t frame;
+    uint8_t change;
+
+    scanRead(&frame);
+    change = frame.bmask != PACE_KEYS;
+    for(uint8_t i = 0; i < OG_AXES; i++) {
+        int16_t delta = frame.axes[i] - PACE_AXES[i];
+        if(delta > OG_SCAN_DELTA || delta < -OG_SCAN_DELTA) change = 1;
+    }
+
+    if(change) {
+        PACE_KEYS = frame.bmask;
+        for(uint8_t i = 0; i < OG_AXES; i++) PACE_AXES[i] = frame.axes[i];
+        PACE_HOLD = OG_SCAN_HOLD_MS;
+        SCAN_SLOW = 0;
+    }
+    if(PACE_HOLD) {
+        PACE_HOLD--;
+        STATS.fastMs++;
+    }else{
+        SCAN_SLOW = 1;
+        STATS.slowMs++;
+    }
+
+    if(PACE_WAIT) PACE_WAIT--;
+    if(SCAN_PAUSED && (!SCAN_SLOW || !PACE_WAIT)) {
+        SCAN_PAUSED = 0;
+        PACE_WAIT = OG_SCAN_SLOW_MS - 1;
+        halAdcStart();                            // Starting the next period.
+    }
+#endif
+}
+
+/*
+ * Clocks the steps the same way the interrupt does and reads DIN where the table has a key, so the reference, which
+ * always reads high, is left out. A full period leaves the channel and the row pattern where they were, so the scan
+ * continues at the same step once it is started again.
+ * */
+uint8_t scanWake(void) {
+    uint8_t step = STEP, left = OG_SCAN_STEPS, keys = 0;
+
+    do {
+        const scanStep *entry = &SCAN_TABLE[step];
+        _delay_us(1);                      // Settling of the counter, the shift register and the multiplexer.
+        if(pgm_read_byte(&entry->mask) && pgm_read_byte(&entry->byte) != OG_SCAN_REF_BYTE) keys |= halScanPins();
+        halClockToggle();
+#if !OG_SCAN_DISCARD
+        halClockToggle();
+#endif
+        if(++step == OG_SCAN_STEPS) step = 0;
+    } while(--left);
+
+    return keys & 1;
+}
+
+#ifdef OG_SCAN_REF_STEP
+// Distance of the step from the reference step in either direction.
+static inline uint8_t scanRefDistance(uint8_t step) {
+    uint8_t ahead = step >= OG_SCAN_REF_STEP ? step - OG_SCAN_REF_STEP : step + OG_SCAN_STEPS - OG_SCAN_REF_STEP;
+
+    return ahead < OG_SCAN_STEPS / 2 ? ahead : OG_SCAN_STEPS - ahead;
+}
+
+/*
+ * Checks the reference and searches for it once it was lost.
+ *
+ * Only the reference steps cost a comparison while the scan is in step. Both have to read high, so a scan one step
+ * ahead reads the key before the reference and one step behind the empty position after it. The search reads DIN on
+ * every step, since a shifted scan may see the reference on a step the table has no key for. Each search period picks
+ * the start of a run of high readings closest to where the reference should be, since a lost or extra clock edge moves
+ * it by a step or two. If it was the only run, it is the reference and the search ends after this one period. Held
+ * keys make a single period ambiguous, the search then ends once two periods in a row pick the same step. A period
+ * without any high reading means there is no reference on the board, the check then stays off until the reference
+ * reads high.
+ * */
+static inline void scanSync(uint8_t step, uint8_t pins) {
+    if(!SYNC_HUNT) {
+        if(step != OG_SCAN_REF_STEP && step != SYNC_END) return;
+        if(pins & 1) {
+            SYNC_FLAGS = SYNC_ARMED;
+        }else if(SYNC_FLAGS) {
+            SYNC_HUNT = OG_SCAN_STEPS;
+            SYNC_HIT = SYNC_LAST = OG_SCAN_STEPS;
+            SYNC_FLAGS = SYNC_ARMED;
+        }
+        return;
+    }
+    if((pins & 1) && !(SYNC_FLAGS & SYNC_HIGH)) {
+        if(SYNC_HIT != OG_SCAN_STEPS) SYNC_FLAGS |= SYNC_MANY;
+        if(SYNC_HIT == OG_SCAN_STEPS || scanRefDistance(step) < scanRefDistance(SYNC_HIT)) SYNC_HIT = step;
+    }
+    SYNC_FLAGS = (SYNC_FLAGS & ~SYNC_HIGH) | (pins & 1 ? SYNC_HIGH : 0);
+    if(--SYNC_HUNT) return;
+    if(SYNC_HIT == OG_SCAN_STEPS) {
+        SYNC_FLAGS = 0;
+    }else if(!(SYNC_FLAGS & SYNC_MANY) || SYNC_HIT == SYNC_LAST) {
+        uint8_t at = STEP + OG_SCAN_REF_STEP;      // Below two periods, which fits as a period has at most 128 steps.
+        if(at >= OG_SCAN_STEPS) at -= OG_SCAN_STEPS;
+        STEP = at >= SYNC_HIT ? at - SYNC_HIT : at + OG_SCAN_STEPS - SYNC_HIT;
+        STATS.resyncs++;
+        SYNC_FLAGS = SYNC_ARMED;
+    }else{
+        SYNC_LAST = SYNC_HIT;
+        SYNC_HIT = OG_SCAN_STEPS;
+        SYNC_HUNT = OG_SCAN_STEPS;
+        SYNC_FLAGS = SYNC_ARMED;
+    }
+}
+#endif
+
+/* 
+ * This interrupt handles ADC data on AIN line and the key on DIN.
+ *
+ * It also does the output clock control by bitbanging, so all outside components are dependent on ADC conversion. CLK is
+ * toggled without a read-modify-write of the port, which the V-USB interrupt could cut in two. The next conversion
+ * is started last, so the interrupt can not nest into itself. It may nest into the V-USB interrupt otherwise.
+ * */
+ISR(ADC_vect, ISR_NOBLOCK) {
+    uint8_t step = STEP;
+    const scanStep *entry = &SCAN_TABLE[step];
+    uint8_t pins = halScanPins(), sample = halAdcRead();
+
+    halClockToggle();                             // Clock tick, the multiplexer settles during the bookkeeping below.
+#if !OG_SCAN_DISCARD
+    halClockToggle();                             // Falling edge right away, each step is a full counter state.
+#endif
+
+    uint8_t axis = pgm_read_byte(&entry->axis);
+    uint8_t byte = pgm_read_byte(&entry->byte);
+    uint8_t mask = pgm_read_byte(&entry->mask);
+    uint8_t keys = (KEYS[byte] & ~mask) | (-(pins & 1) & mask);
+
+    // Nothing is stored while the reference is searched, the samples belong to unknown steps.
+    if(!SYNC_HUNT) {
+        if(keys != KEYS[byte]) {
+            LATCH[byte] |= keys & ~KEYS[byte];    // Only the press is latched, the current state follows the key.
+            KEYS[byte] = keys;
+            SCAN_NEW = 1;
+#if OG_EDGE_TIMES
+            uint16_t *at = keys & mask ? TIMING.press : TIMING.release;
+            at[pgm_read_byte(&entry->key)] = clockStamp();
+#endif
+        }
+        AXES[axis] = sample;                      // Axis changes are reported by the filter, see filter.h.
+    }
+    STEP = step + 1 == OG_SCAN_STEPS ? 0 : step + 1;
+#ifdef OG_SCAN_REF_STEP
+    scanSync(step, pins);
+#endif
+    if(STEP || !SCAN_SLOW) halAdcStart();         // Starting new ADC conversion.
+    else SCAN_PAUSED = 1;                         // Waiting for scanPace() at rest.
+}
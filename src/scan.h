@@ -0,0 +1,107 @@
+/*
+ *  Input scan of 'Open Game Pad'.
+ *
+ *  CLK clocks the 74HC163 counter, whose state selects the 74HC4052 channels and the 74HC595 row. Every finished
+ *  ADC conversion advances the scan by one step (one CLK edge). What a step means is looked up in the decode table of the
+ *  board, so the interrupt does the same few operations on every step and a board revision only needs a new table.
+ *
+ *  Timing: a step is one conversion of 13 ADC cycles (202 CPU cycles) plus the interrupt up to the start of the next
+ *  conversion, about 18 us in total. A USB packet received during a step stretches it by up to 100 us. CLK switches the
+ *  multiplexer at the start of a step and the conversion starts a few microseconds later, at the end of the interrupt.
+ *
+ *  With OG_SCAN_DISCARD each counter state takes two steps. The first one reads the key at its end and throws away its
+ *  conversion, so the key read fills the settling time of the analog input. The second step samples the axis from the
+ *  settled multiplexer. A classic period takes 40 steps (about 0.7 ms) and every axis is sampled each 8 steps (about
+ *  140 us), always at the same point of the period. Without OG_SCAN_DISCARD both happen in the same step and all times
+ *  halve.
+ *
+ *  Sample age: the report is packed right before it is handed to the driver, so each axis in it is at most one axis
+ *  interval plus one conversion old at that time. The report then waits for the next poll of the host, at most
+ *  USB_CFG_INTR_POLL_INTERVAL ms. Keys have the same age bound as the axes. The axis filter runs once per millisecond,
+ *  which adds up to 1 ms to the axes.
+ *
+ *  At rest (see OG_SCAN_SLOW_MS) the scan stops at the end of each period and scanPace() starts the next one, which adds
+ *  up to OG_SCAN_SLOW_MS to both ages until the first change switches back to the full rate.
+ * */
+
+#ifndef __SCAN_H__
+#define __SCAN_H__
+
+#include <stdint.h>
+
+#include "ogconfig.h"
+#include "ogpad.h"
+
+_Static_assert(OG_AXES <= OG_MUX_CHANNELS, "every axis needs a multiplexer channel");
+_Static_assert(OG_AXES % 2 == 0, "axes are paired into joysticks");
+_Static_assert(OG_SCAN_STATES <= 64, "scan steps are counted in one byte");
+_Static_assert(OG_SCAN_STATES % OG_MUX_CHANNELS == 0, "every scan period must start on the same multiplexer channel");
+
+// Clock edges in one full scan period. Every counter state takes a rising and a falling edge of CLK, after
+// OG_SCAN_STATES states the channels and the key rows repeat.
+#define OG_SCAN_EDGES       (2 * OG_SCAN_STATES)
+// Steps in one full scan period, the length of the decode table. Each step makes one conversion.
+#define OG_SCAN_STEPS       (OG_SCAN_DISCARD ? OG_SCAN_EDGES : OG_SCAN_EDGES / 2)
+// Axis index of steps whose conversion is thrown away.
+#define OG_SCAN_SINK        OG_AXES
+
+/*
+ *  One step of the decode table.
+ *
+ *  'axis' receives the conversion made during the step, or OG_SCAN_SINK. DIN is read at the end of the step into the
+ *  bits 'mask' of byte 'byte' of the button mask, 'key' is the number of that key. Steps without a key have a zero mask.
+ *  Without OG_SCAN_DISCARD every step does both. The entry takes 4 bytes, so it is found with a shift.
+ * */
+typedef struct {
+    uint8_t axis;
+    uint8_t byte;
+    uint8_t mask;
+    uint8_t key;
+} scanStep;
+
+// Entries of the decode table: an axis sample with a key read, a key read, an axis sample and a step which only lets
+// the inputs settle.
+#define OG_SCAN_READ(a, n)  { (a), (n) / 8, 1 << ((n) % 8), (n) < OG_BUTTONS ? (n) : OG_BUTTONS }
+#define OG_SCAN_KEY(n)      OG_SCAN_READ(OG_SCAN_SINK, n)
+#define OG_SCAN_AXIS(n)     { (n), 0, 0, 0 }
+#define OG_SCAN_SETTLE      { OG_SCAN_SINK, 0, 0, 0 }
+/*
+ *  Reference read. DIN must always be high during this step.
+ *
+ *  A table with a reference also defines OG_SCAN_REF_STEP, the index of the entry. The scan then checks the reference on
+ *  every period. If it reads low, the scan follows the next periods without storing anything. Each of them picks the key
+ *  step reading high closest to OG_SCAN_REF_STEP, and the step counter is shifted so that step becomes OG_SCAN_REF_STEP
+ *  again: after the first period if no other key step read high, otherwise once two periods in a row pick the same step.
+ *  A single period can not tell the reference from a held key. A held key closer than the reference is taken for it,
+ *  the reference check then fails again once the key is released and a new search starts. A period in which no key step
+ *  reads high turns the check off, the board has no reference.
+ * */
+#define OG_SCAN_REF_BYTE    4
+#define OG_SCAN_REF_KEY     (8 * OG_SCAN_REF_BYTE)
+#define OG_SCAN_REF         OG_SCAN_KEY(OG_SCAN_REF_KEY)
+
+// Set by the scan whenever a key changes and by the main loop whenever a filtered axis changes. Cleared by the reader.
+extern volatile uint8_t SCAN_NEW;
+#if OG_EDGE_TIMES
+// Time stamps of the last edges, written by the scan.
+extern timing_t TIMING;
+#endif
+
+/* Starts the scan. Every finished conversion clocks the counter and starts the next conversion. */
+void scanStart(void);
+/* Stops the scan. The conversion in progress is dropped, so the scan stays at its current step. */
+void scanStop(void);
+/* Copies the latest scanned state atomically. Axes are raw 8-bit ADC readings. */
+void scanRead(frame_t *frame);
+#if OG_EDGE_TIMES
+/* Copies 'len' bytes of TIMING from the even position 'pos', every time stamp atomically. */
+void scanTimes(uint8_t *data, uint8_t pos, uint8_t len);
+#endif
+/* Clears the press latches of the keys in 'mask'. */
+void scanLatchClear(uint32_t mask);
+/* Chooses the scan rate from the latest changes. Must be called once per millisecond. */
+void scanPace(void);
+/* Clocks the stopped scan through one full period without the ADC. Returns non zero if any key is pressed. */
+uint8_t scanWake(void);
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ *  Scan decode table of the arcade 'Open Game Pad' board.
+ *
+ *  The rising CLK edge advances the counter, two cascaded 74HC163 give the 32 states of OG_COUNTER_BITS 5. Q0..Q2 select
+ *  the 74HC4051 channel, so state Q samples axis Q & 7 on AIN. The key matrix is decoded on the board from all five bits
+ *  and routes key Q to DIN, there is no row latch.
+ *
+ *  With OG_SCAN_DISCARD steps 2Q + 1 and 2Q + 2 (modulo OG_SCAN_STEPS) belong to counter state Q. The first step lets
+ *  the multiplexer settle, its conversion is thrown away and the key is read at its end. The second step samples the
+ *  axis. Without it step Q is counter state Q and does both.
+ *
+ *  With OG_SCAN_SYNC the position of key 31 holds the reference instead.
+ * */
+
+#if OG_SCAN_SYNC
+#define OG_SCAN_KEY31       OG_SCAN_REF_KEY
+#define OG_SCAN_REF_STEP    (OG_SCAN_DISCARD ? 63 : 31)
+#else
+#define OG_SCAN_KEY31       31
+#endif
+
+#if OG_SCAN_DISCARD
+PROGMEM static const scanStep SCAN_TABLE[OG_SCAN_STEPS] = {
+    // Q = 31
+    OG_SCAN_AXIS(7),
+    // Q = 0..3
+    OG_SCAN_KEY(0),    OG_SCAN_AXIS(0),
+    OG_SCAN_KEY(1),    OG_SCAN_AXIS(1),
+    OG_SCAN_KEY(2),    OG_SCAN_AXIS(2),
+    OG_SCAN_KEY(3),    OG_SCAN_AXIS(3),
+    // Q = 4..7
+    OG_SCAN_KEY(4),    OG_SCAN_AXIS(4),
+    OG_SCAN_KEY(5),    OG_SCAN_AXIS(5),
+    OG_SCAN_KEY(6),    OG_SCAN_AXIS(6),
+    OG_SCAN_KEY(7),    OG_SCAN_AXIS(7),
+    // Q = 8..11
+    OG_SCAN_KEY(8),    OG_SCAN_AXIS(0),
+    OG_SCAN_KEY(9),    OG_SCAN_AXIS(1),
+    OG_SCAN_KEY(10),   OG_SCAN_AXIS(2),
+    OG_SCAN_KEY(11),   OG_SCAN_AXIS(3),
+    // Q = 12..15
+    OG_SCAN_KEY(12),   OG_SCAN_AXIS(4),
+    OG_SCAN_KEY(13),   OG_SCAN_AXIS(5),
+    OG_SCAN_KEY(14),   OG_SCAN_AXIS(6),
+    OG_SCAN_KEY(15),   OG_SCAN_AXIS(7),
+    // Q = 16..19
+    OG_SCAN_KEY(16),   OG_SCAN_AXIS(0),
+    OG_SCAN_KEY(17),   OG_SCAN_AXIS(1),
+    OG_SCAN_KEY(18),   OG_SCAN_AXIS(2),
+    OG_SCAN_KEY(19),   OG_SCAN_AXIS(3),
+    // Q = 20..23
+    OG_SCAN_KEY(20),   OG_SCAN_AXIS(4),
+    OG_SCAN_KEY(21),   OG_SCAN_AXIS(5),
+    OG_SCAN_KEY(22),   OG_SCAN_AXIS(6),
+    OG_SCAN_KEY(23),   OG_SCAN_AXIS(7),
+    // Q = 24..27
+    OG_SCAN_KEY(24),   OG_SCAN_AXIS(0),
+    OG_SCAN_KEY(25),   OG_SCAN_AXIS(1),
+    OG_SCAN_KEY(26),   OG_SCAN_AXIS(2),
+    OG_SCAN_KEY(27),   OG_SCAN_AXIS(3),
+    // Q = 28..31
+    OG_SCAN_KEY(28),   OG_SCAN_AXIS(4),
+    OG_SCAN_KEY(29),   OG_SCAN_AXIS(5),
+    OG_SCAN_KEY(30),   OG_SCAN_AXIS(6),
+    OG_SCAN_KEY(OG_SCAN_KEY31)
+};
+#else
+PROGMEM static const scanStep SCAN_TABLE[OG_SCAN_STEPS] = {
+    // Q = 0..3
+    OG_SCAN_READ(0, 0), OG_SCAN_READ(1, 1), OG_SCAN_READ(2, 2), OG_SCAN_READ(3, 3),
+    // Q = 4..7
+    OG_SCAN_READ(4, 4), OG_SCAN_READ(5, 5), OG_SCAN_READ(6, 6), OG_SCAN_READ(7, 7),
+    // Q = 8..11
+    OG_SCAN_READ(0, 8), OG_SCAN_READ(1, 9), OG_SCAN_READ(2, 10), OG_SCAN_READ(3, 11),
+    // Q = 12..15
+    OG_SCAN_READ(4, 12), OG_SCAN_READ(5, 13), OG_SCAN_READ(6, 14), OG_SCAN_READ(7, 15),
+    // Q = 16..19
+    OG_SCAN_READ(0, 16), OG_SCAN_READ(1, 17), OG_SCAN_READ(2, 18), OG_SCAN_READ(3, 19),
+    // Q = 20..23
+    OG_SCAN_READ(4, 20), OG_SCAN_READ(5, 21), OG_SCAN_READ(6, 22), OG_SCAN_READ(7, 23),
+    // Q = 24..27
+    OG_SCAN_READ(0, 24), OG_SCAN_READ(1, 25), OG_SCAN_READ(2, 26), OG_SCAN_READ(3, 27),
+    // Q = 28..31
+    OG_SCAN_READ(4, 28), OG_SCAN_READ(5, 29), OG_SCAN_READ(6, 30), OG_SCAN_READ(7, OG_SCAN_KEY31)
+};
+#endif
@@ -0,0 +1,68 @@
+/*
+ *  Scan decode table of the classic 'Open Game Pad' board.
+ *
+ *  The rising CLK edge advances the counter. Q0/Q1 select multiplexer channel Q & 3: joystick axis Q & 3 on AIN and key
+ *  column X(Q & 3) on DIN. The 74HC595 latches the next row on every rising Q1, i.e. when Q & 3 becomes 2, and walks the
+ *  five rows Y1..Y5. The rows therefore repeat every 20 counter states (OG_SCAN_STATES), not every 16, and the table
+ *  counts the states S of its own period: channel S & 3, row window S / 4 shifted by two states. Key N sits at row N / 4,
+ *  column N % 4. Row Y5 only carries the stick clicks X1J and X2J, keys 16 and 17, its columns X3 and X4 hold no switch.
+ *
+ *  With OG_SCAN_DISCARD steps 2S + 1 and 2S + 2 (modulo OG_SCAN_STEPS) belong to state S. The first step lets the
+ *  multiplexer settle, its conversion is thrown away and the key is read at its end. The second step samples the axis.
+ *  Without it step S is state S and does both.
+ *
+ *  With OG_SCAN_SYNC the free position Y5/X3 is read as the reference, which needs a diode from Y5 to X3 like the ones
+ *  of the switches. No key is lost for it. Without the diode the scan finds no reference and leaves the check off.
+ * */
+
+#if OG_SCAN_SYNC
+#define OG_SCAN_Y5X3(a)     OG_SCAN_READ(a, OG_SCAN_REF_KEY)
+#define OG_SCAN_REF_STEP    (OG_SCAN_DISCARD ? 29 : 14)
+#else
+#define OG_SCAN_Y5X3(a)     { (a), 0, 0, 0 }
+#endif
+
+#if OG_SCAN_DISCARD
+PROGMEM static const scanStep SCAN_TABLE[OG_SCAN_STEPS] = {
+    // S = 19
+    OG_SCAN_AXIS(3),
+    // S = 0..3, rows Y1 and Y2
+    OG_SCAN_KEY(0),  OG_SCAN_AXIS(0),
+    OG_SCAN_KEY(1),  OG_SCAN_AXIS(1),
+    OG_SCAN_KEY(6),  OG_SCAN_AXIS(2),
+    OG_SCAN_KEY(7),  OG_SCAN_AXIS(3),
+    // S = 4..7, rows Y2 and Y3
+    OG_SCAN_KEY(4),  OG_SCAN_AXIS(0),
+    OG_SCAN_KEY(5),  OG_SCAN_AXIS(1),
+    OG_SCAN_KEY(10), OG_SCAN_AXIS(2),
+    OG_SCAN_KEY(11), OG_SCAN_AXIS(3),
+    // S = 8..11, rows Y3 and Y4
+    OG_SCAN_KEY(8),  OG_SCAN_AXIS(0),
+    OG_SCAN_KEY(9),  OG_SCAN_AXIS(1),
+    OG_SCAN_KEY(14), OG_SCAN_AXIS(2),
+    OG_SCAN_KEY(15), OG_SCAN_AXIS(3),
+    // S = 12..15, rows Y4 and Y5
+    OG_SCAN_KEY(12), OG_SCAN_AXIS(0),
+    OG_SCAN_KEY(13), OG_SCAN_AXIS(1),
+    OG_SCAN_Y5X3(OG_SCAN_SINK), OG_SCAN_AXIS(2),
+    OG_SCAN_SETTLE,  OG_SCAN_AXIS(3),
+    // S = 16..19, rows Y5 and Y1
+    OG_SCAN_KEY(16), OG_SCAN_AXIS(0),
+    OG_SCAN_KEY(17), OG_SCAN_AXIS(1),
+    OG_SCAN_KEY(2),  OG_SCAN_AXIS(2),
+    OG_SCAN_KEY(3)
+};
+#else
+PROGMEM static const scanStep SCAN_TABLE[OG_SCAN_STEPS] = {
+    // S = 0..3, rows Y1 and Y2
+    OG_SCAN_READ(0, 0),  OG_SCAN_READ(1, 1),  OG_SCAN_READ(2, 6),  OG_SCAN_READ(3, 7),
+    // S = 4..7, rows Y2 and Y3
+    OG_SCAN_READ(0, 4),  OG_SCAN_READ(1, 5),  OG_SCAN_READ(2, 10), OG_SCAN_READ(3, 11),
+    // S = 8..11, rows Y3 and Y4
+    OG_SCAN_READ(0, 8),  OG_SCAN_READ(1, 9),  OG_SCAN_READ(2, 14), OG_SCAN_READ(3, 15),
+    // S = 12..15, rows Y4 and Y5
+    OG_SCAN_READ(0, 12), OG_SCAN_READ(1, 13), OG_SCAN_Y5X3(2),     OG_SCAN_AXIS(3),
+    // S = 16..19, rows Y5 and Y1
+    OG_SCAN_READ(0, 16), OG_SCAN_READ(1, 17), OG_SCAN_READ(2, 2),  OG_SCAN_READ(3, 3)
+};
+#endif
@@ -0,0 +1,222 @@
+/*
+ *  Persistent settings and counters of 'Open Game Pad'.
+ * */
+
+#include<avr/pgmspace.h>
+#include<util/crc16.h>
+#include<string.h>
+
+#include "settings.h"
+#include "socd.h"
+
+_Static_assert(sizeof(calibration_t) <= EE_PAYLOAD, "calibration does not fit into a journal record");
+_Static_assert(OG_BUTTONS <= EE_PAYLOAD, "button map does not fit into a journal record");
+_Static_assert(sizeof(tuning_t) <= EE_PAYLOAD, "tuning does not fit into a journal record");
+_Static_assert(OG_PRESS_RECORDS <= 5, "add more press counter records to EE_RECORDS");
+_Static_assert(OG_PROFILES >= 1 && OG_PROFILES <= 4, "add more button map records to EE_RECORDS");
+
+calibration_t CALIB;
+tuning_t TUNING;
+uint8_t BMAP[OG_PROFILES][OG_BUTTONS];
+uint32_t PRESSES[OG_BUTTONS];
+
+// Presses counted since the counters were saved last time.
+static uint16_t UNSAVED;
+// Press counter records changed since they were saved last time, one bit per record.
+static uint8_t CHANGED;
+
+// Bytes left in the configuration transfer, record being transferred, its size and the position inside of it.
+static uint8_t XFER_LEFT, XFER_TAG, XFER_SIZE, XFER_POS;
+// CRC of the record being transferred.
+static uint16_t XFER_CRC;
+// Payload of the record being received. It is only applied once its CRC matches.
+static uint8_t XFER_BUF[EE_PAYLOAD];
+// Position of the first CRC byte after the payload. Tag byte is at position 0.
+#define XFER_CRC_POS    (XFER_SIZE + 1)
+// Value of XFER_TAG after a broken record. The rest of the transfer is refused.
+#define XFER_ERROR      0xFF
+
+// Journal record of the n-th group of press counters. The last group may be shorter than the others.
+#define PRESS_RECORD(n) [OG_TAG_PRESSES + (n)] = { \
+    &PRESSES[(n) * OG_PRESSES_PER_RECORD], \
+    ((OG_BUTTONS - (n) * OG_PRESSES_PER_RECORD) < OG_PRESSES_PER_RECORD ? \
+        (OG_BUTTONS - (n) * OG_PRESSES_PER_RECORD) : OG_PRESSES_PER_RECORD) * sizeof(uint32_t) }
+
+const eeRecord EE_RECORDS[OG_TAGS] PROGMEM = {
+    [OG_TAG_CALIB] = { &CALIB, sizeof(CALIB) },
+    [OG_TAG_MAP] = { BMAP[0], sizeof(BMAP[0]) },
+    PRESS_RECORD(0),
+#if OG_PRESS_RECORDS > 1
+    PRESS_RECORD(1),
+#endif
+#if OG_PRESS_RECORDS > 2
+    PRESS_RECORD(2),
+#endif
+#if OG_PRESS_RECORDS > 3
+    PRESS_RECORD(3),
+#endif
+#if OG_PRESS_RECORDS > 4
+    PRESS_RECORD(4),
+#endif
+    [OG_TAG_TUNING] = { &TUNING, sizeof(TUNING) },
+#if OG_PROFILES > 1
+    [OG_TAG_MAPS] = { BMAP[1], sizeof(BMAP[1]) },
+#endif
+#if OG_PROFILES > 2
+    [OG_TAG_MAPS + 1] = { BMAP[2], sizeof(BMAP[2]) },
+#endif
+#if OG_PROFILES > 3
+    [OG_TAG_MAPS + 2] = { BMAP[3], sizeof(BMAP[3]) },
+#endif
+};
+
+/*
+ * Replaces the tuning values the input processing can not take with their defaults. Stored records and written blobs
+ * may come from other firmware versions or from a broken host tool. Filter shifts of 16 and more overflow the 16-bit
+ * values, profiles and SOCD modes index tables.
+ * */
+static void tuningCheck(void) {
+    for(uint8_t i = 0; i < OG_AXES; i++) {
+        if(TUNING.filterRest[i] > 15) TUNING.filterRest[i] = OG_FILTER_REST;
+        if(TUNING.filterSpeed[i] > 15) TUNING.filterSpeed[i] = OG_FILTER_SPEED;
+    }
+    if(TUNING.socdVertical > OG_SOCD_PRIORITY) TUNING.socdVertical = OG_SOCD_VERTICAL;
+    if(TUNING.socdHorizontal > OG_SOCD_PRIORITY) TUNING.socdHorizontal = OG_SOCD_HORIZONTAL;
+    if(TUNING.profile >= OG_PROFILES) TUNING.profile = 0;
+}
+
+void settingsInit(void) {
+    uint8_t i;
+
+    CALIB.osccal = OG_OSCCAL_UNSET;
+    for(i = 0; i < OG_AXES; i++) {
+        CALIB.center[i] = 128;
+        CALIB.min[i] = 0;
+        CALIB.max[i] = 255;
+        TUNING.filterRest[i] = OG_FILTER_REST;
+        TUNING.filterSpeed[i] = OG_FILTER_SPEED;
+        TUNING.filterBand[i] = OG_FILTER_BAND;
+    }
+    TUNING.socdVertical = OG_SOCD_VERTICAL;
+    TUNING.socdHorizontal = OG_SOCD_HORIZONTAL;
+    for(i = 0; i < OG_AXES / 2; i++) {
+        TUNING.stickDeadzone[i] = OG_STICK_DEADZONE;
+        TUNING.stickOuter[i] = OG_STICK_OUTER;
+    }
+    for(i = 0; i < OG_BUTTONS; i++)
+        for(uint8_t p = 0; p < OG_PROFILES; p++) BMAP[p][i] = i;
+
+    eeJournalInit();
+    tuningCheck();
+}
+
+void settingsSaveOsccal(uint8_t osccal) {
+    // Neighbouring values are equally good, so those are not worth an EEPROM write.
+    if(CALIB.osccal == OG_OSCCAL_UNSET || (uint8_t)(osccal - CALIB.osccal + 1) > 2) {
+        CALIB.osccal = osccal;
+        eeJournalSave(OG_TAG_CALIB);
+    }
+}
+
+void settingsCountPresses(uint32_t pressed) {
+    uint8_t i, k = 0, rec = 0;
+
+    for(i = 0; pressed; i++, pressed >>= 1) {
+        if(pressed & 1) {
+            PRESSES[i]++;
+            UNSAVED++;
+            CHANGED |= 1 << rec;
+        }
+        if(++k == OG_PRESSES_PER_RECORD) {
+            k = 0;
+            rec++;
+        }
+    }
+
+    // Counters are saved in batches to keep the EEPROM wear independent from how often the keys are pressed.
+    if(UNSAVED >= OG_EE_COUNTER_SAVE_PRESSES) {
+        for(rec = 0; rec < OG_PRESS_RECORDS; rec++)
+            if(CHANGED & (1 << rec)) eeJournalSave(OG_TAG_PRESSES + rec);
+        UNSAVED = 0;
+        CHANGED = 0;
+    }
+}
+
+// Reads the size of the record from its description.
+static uint8_t recordSize(uint8_t tag) {
+    return pgm_read_byte(&EE_RECORDS[tag].size);
+}
+
+// Reads the RAM image of the record from its description.
+static uint8_t *recordData(uint8_t tag) {
+    return pgm_read_ptr(&EE_RECORDS[tag].data);
+}
+
+void settingsTransferStart(uint16_t len) {
+    XFER_LEFT = len > 0xFF ? 0xFF : len;
+    XFER_TAG = 0;
+    XFER_SIZE = recordSize(0);
+    XFER_POS = 0;
+    XFER_CRC = 0xFFFF;
+}
+
+uint8_t settingsRead(uint8_t *data, uint8_t len) {
+    uint8_t i, b;
+
+    for(i = 0; i < len && XFER_TAG < OG_TAGS; i++) {
+        if(XFER_POS == 0)
+            b = XFER_TAG;
+        else if(XFER_POS < XFER_CRC_POS)
+            b = recordData(XFER_TAG)[XFER_POS - 1];
+        else
+            b = XFER_POS == XFER_CRC_POS ? XFER_CRC : XFER_CRC >> 8;
+
+        if(XFER_POS < XFER_CRC_POS)
+            XFER_CRC = _crc_ccitt_update(XFER_CRC, b);
+        data[i] = b;
+
+        if(++XFER_POS > XFER_CRC_POS + 1) {         // Record is complete, going to the next one.
+            if(++XFER_TAG < OG_TAGS) XFER_SIZE = recordSize(XFER_TAG);
+            XFER_POS = 0;
+            XFER_CRC = 0xFFFF;
+        }
+    }
+
+    return i;
+}
+
+uint8_t settingsWrite(uint8_t *data, uint8_t len) {
+    uint8_t i, b;
+
+    if(len > XFER_LEFT) len = XFER_LEFT;
+    XFER_LEFT -= len;
+    for(i = 0; i < len && XFER_TAG != XFER_ERROR; i++) {
+        b = data[i];
+        if(XFER_POS == 0) {                         // Tag byte opens a new record.
+            if(b >= OG_TAGS) {
+                XFER_TAG = XFER_ERROR;
+                break;
+            }
+            XFER_TAG = b;
+            XFER_SIZE = recordSize(b);
+            XFER_CRC = 0xFFFF;
+        }
+
+        if(XFER_POS < XFER_CRC_POS) {
+            XFER_CRC = _crc_ccitt_update(XFER_CRC, b);
+            if(XFER_POS) XFER_BUF[XFER_POS - 1] = b;
+            XFER_POS++;
+        }else if(b != (uint8_t) (XFER_POS == XFER_CRC_POS ? XFER_CRC : XFER_CRC >> 8)) {
+            XFER_TAG = XFER_ERROR;                  // Corrupted record is dropped, the ones before it stay applied.
+        }else if(++XFER_POS > XFER_CRC_POS + 1) {   // Record is valid: applying it and handing it to the journal.
+            memcpy(recordData(XFER_TAG), XFER_BUF, XFER_SIZE);
+            if(XFER_TAG == OG_TAG_TUNING) tuningCheck();
+            eeJournalSave(XFER_TAG);
+            XFER_POS = 0;
+        }
+    }
+
+    if(XFER_TAG == XFER_ERROR) return 0xff;
+    if(XFER_LEFT) return 0;
+    return XFER_POS ? 0xff : 1;                     // A record cut in the middle is an error too.
+}
@@ -0,0 +1,99 @@
+/*
+ *  Persistent settings and counters of 'Open Game Pad'.
+ *
+ *  Everything defined here lives in RAM and is backed by the EEPROM journal. The RAM images are loaded once on boot and
+ *  then written back in the background whenever they change.
+ * */
+
+#ifndef __SETTINGS_H__
+#define __SETTINGS_H__
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "ogconfig.h"
+#include "eejournal.h"
+
+// Amount of lifetime press counters that fit into one journal record.
+#define OG_PRESSES_PER_RECORD   (EE_PAYLOAD / 4)
+// Amount of journal records used by the lifetime press counters.
+#define OG_PRESS_RECORDS        ((OG_BUTTONS + OG_PRESSES_PER_RECORD - 1) / OG_PRESSES_PER_RECORD)
+// OSCCAL value of a pad which was never calibrated.
+#define OG_OSCCAL_UNSET         0xFF
+
+// Journal tags of all persistent records.
+enum {
+    OG_TAG_CALIB,                                   // Oscillator and joystick calibration.
+    OG_TAG_MAP,                                     // Button map of the first profile.
+    OG_TAG_PRESSES,                                 // First of the lifetime press counter records.
+    OG_TAG_TUNING = OG_TAG_PRESSES + OG_PRESS_RECORDS, // Input processing parameters.
+    OG_TAG_MAPS,                                    // Button maps of the other profiles.
+    OG_TAGS = OG_TAG_MAPS + OG_PROFILES - 1
+};
+
+/*
+ *  Calibration data.
+ *
+ *  OSCCAL is stored so the oscillator starts close to 16.5 MHz on the next boot. Joystick values are raw 8-bit ADC readings.
+ * */
+typedef struct {
+    uint8_t osccal;                 // RC oscillator calibration found on the last USB reset.
+    uint8_t center[OG_AXES];        // ADC value of each axis at rest.
+    uint8_t min[OG_AXES];           // ADC value of each axis at full deflection below the center.
+    uint8_t max[OG_AXES];           // ADC value of each axis at full deflection above the center.
+} calibration_t;
+
+/*
+ *  Input processing parameters.
+ *
+ *  Applied right away when changed, so they can be tuned while the pad is in use.
+ * */
+typedef struct {
+    uint8_t filterRest[OG_AXES];    // Filter shift at rest, see filter.h.
+    uint8_t filterSpeed[OG_AXES];   // Distance of the raw reading, as a power of two, which lowers the shift by one.
+    uint8_t filterBand[OG_AXES];    // Half width of the change band in counts, or OG_FILTER_BAND_AUTO.
+    uint8_t stickDeadzone[OG_AXES / 2]; // Radial deadzone of each joystick, see stick.h.
+    uint8_t stickOuter[OG_AXES / 2];    // Radius of the outer ring.
+    uint8_t stickCurve[OG_AXES / 2];    // Response curve, one of OG_CURVE_*.
+    uint8_t stickSquare[OG_AXES / 2];   // Non zero to map the round gate to the square.
+    uint8_t socdVertical;           // SOCD mode of up and down, one of OG_SOCD_*, see socd.h.
+    uint8_t socdHorizontal;         // SOCD mode of right and left.
+    uint8_t profile;                // Active button map, see remap.h.
+} tuning_t;
+
+// Current calibration.
+extern calibration_t CALIB;
+// Current input processing parameters.
+extern tuning_t TUNING;
+// Button maps of all profiles. Entry N holds the report bit of the physical key N.
+extern uint8_t BMAP[OG_PROFILES][OG_BUTTONS];
+// Lifetime amount of presses of each physical key.
+extern uint32_t PRESSES[OG_BUTTONS];
+// Journal record descriptions, indexed by tag.
+extern const eeRecord EE_RECORDS[OG_TAGS] PROGMEM;
+
+/* Fills the defaults and loads the stored settings from the EEPROM. */
+void settingsInit(void);
+/* Stores the new OSCCAL value if it moved away from the stored one. */
+void settingsSaveOsccal(uint8_t osccal);
+/* Counts new presses. 'pressed' holds a bit for every key which went down since the previous call. */
+void settingsCountPresses(uint32_t pressed);
+
+/*
+ *  Streamed configuration transfer.
+ *
+ *  A configuration blob is a sequence of records: [tag][payload][CRC-16 low][CRC-16 high]. The payload size is the size
+ *  of the record with this tag, the CRC is CRC-16/CCITT (initial value 0xFFFF, reflected) over the tag and the payload.
+ *  Reading returns every record. Writing accepts any subset of them in any order. Each record is checked as soon as its
+ *  last byte arrives, applied to its RAM image and queued to the EEPROM journal, so the blob never has to fit into RAM.
+ *  Tuning values the processing can not take are replaced by their defaults.
+ * */
+
+/* Starts a new transfer of 'len' bytes. Must be called from usbFunctionSetup(). */
+void settingsTransferStart(uint16_t len);
+/* Fills the next chunk of the blob being read. Returns the amount of bytes written, less than 'len' at the end. */
+uint8_t settingsRead(uint8_t *data, uint8_t len);
+/* Consumes the next chunk of the blob being written. Returns 1 at the end, 0 if more data is expected and 0xff on error. */
+uint8_t settingsWrite(uint8_t *data, uint8_t len);
+
+#endif
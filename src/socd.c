@@ -0,0 +1,49 @@
+/*
+ *  SOCD cleaning of 'Open Game Pad'.
+ * */
+
+#include "socd.h"
+#include "settings.h"
+
+// D-pad bits of the vertical and the horizontal pair. The first direction of each pair is the one with priority.
+#define SOCD_UP         0x01
+#define SOCD_RIGHT      0x02
+#define SOCD_DOWN       0x04
+#define SOCD_LEFT       0x08
+#define SOCD_VERTICAL   (SOCD_UP | SOCD_DOWN)
+#define SOCD_HORIZONTAL (SOCD_RIGHT | SOCD_LEFT)
+
+// D-pad keys of the previous call and the direction of each pair which was pressed last.
+static uint8_t PREV;
+static uint8_t LAST;
+
+/*
+ * A pair where both keys went down at once keeps its previous last direction.
+ * */
+void socdTrack(uint32_t bmask) {
+    uint8_t dpad = bmask & 0x0F, pressed = dpad & ~PREV;
+
+    if((pressed & SOCD_VERTICAL) && (pressed & SOCD_VERTICAL) != SOCD_VERTICAL)
+        LAST = (LAST & ~SOCD_VERTICAL) | (pressed & SOCD_VERTICAL);
+    if((pressed & SOCD_HORIZONTAL) && (pressed & SOCD_HORIZONTAL) != SOCD_HORIZONTAL)
+        LAST = (LAST & ~SOCD_HORIZONTAL) | (pressed & SOCD_HORIZONTAL);
+    PREV = dpad;
+}
+
+// Returns the bits of the pair to clear when both are down. Without a known order the pair goes neutral.
+static uint8_t socdClear(uint8_t mode, uint8_t pair, uint8_t second) {
+    if(mode == OG_SOCD_NEUTRAL || ((mode == OG_SOCD_LAST || mode == OG_SOCD_FIRST) && !(LAST & pair))) return pair;
+    if(mode == OG_SOCD_LAST) return pair & ~LAST;
+    if(mode == OG_SOCD_FIRST) return pair & LAST;
+    if(mode == OG_SOCD_PRIORITY) return second;
+    return 0;
+}
+
+uint32_t socdApply(uint32_t bmask) {
+    uint8_t dpad = bmask, clear = 0;
+
+    if((dpad & SOCD_VERTICAL) == SOCD_VERTICAL) clear |= socdClear(TUNING.socdVertical, SOCD_VERTICAL, SOCD_DOWN);
+    if((dpad & SOCD_HORIZONTAL) == SOCD_HORIZONTAL) clear |= socdClear(TUNING.socdHorizontal, SOCD_HORIZONTAL, SOCD_LEFT);
+
+    return bmask & ~(uint32_t) clear;
+}
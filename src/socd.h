@@ -0,0 +1,31 @@
+/*
+ *  SOCD cleaning of 'Open Game Pad'.
+ *
+ *  Resolves simultaneous opposite cardinal directions on the d-pad keys 0 to 3 (up, right, down, left) before they are
+ *  reported. The vertical and the horizontal pair each have their own mode, so the usual tournament rules can be set up:
+ *  - neutral on both pairs,
+ *  - last input wins on both pairs,
+ *  - up priority with neutral or last input wins on the horizontal pair.
+ *  The history is one byte of previous keys and one byte with the last pressed direction of each pair.
+ * */
+
+#ifndef __SOCD_H__
+#define __SOCD_H__
+
+#include <stdint.h>
+
+// Modes of a pair of opposite directions.
+enum {
+    OG_SOCD_PASS,                   // Both directions are reported.
+    OG_SOCD_NEUTRAL,                // Neither direction is reported.
+    OG_SOCD_LAST,                   // The direction pressed last is reported.
+    OG_SOCD_FIRST,                  // The direction pressed first is reported.
+    OG_SOCD_PRIORITY                // Up wins over down, right wins over left.
+};
+
+/* Follows the order of the d-pad presses. Must be called with every new button mask. */
+void socdTrack(uint32_t bmask);
+/* Returns the button mask with the opposite directions resolved. */
+uint32_t socdApply(uint32_t bmask);
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ *  Stack high-water mark of 'Open Game Pad', see stack.h.
+ * */
+
+#include<avr/io.h>
+
+#include "stack.h"
+
+// End of .bss and start of the free RAM, set by the linker.
+extern uint8_t __heap_start;
+
+/*
+ * Paints the free RAM.
+ *
+ * Runs from .init3, after the stack pointer and the zero register are set up and before anything was pushed, so all the
+ * RAM up to the stack pointer is free. The section falls through to the rest of the start-up code, so there must be no
+ * return.
+ * */
+void __attribute__((naked, used, section(".init3"))) stackPaint(void) {
+    uint8_t *p = &__heap_start;
+
+    while(p < (uint8_t *) SP) *p++ = OG_STACK_CANARY;
+}
+
+uint16_t stackFree(void) {
+    const uint8_t *p = &__heap_start;
+
+    while(p < (const uint8_t *) RAMEND && *p == OG_STACK_CANARY) p++;
+
+    return p - &__heap_start;
+}
@@ -0,0 +1,23 @@
+/*
+ *  Stack high-water mark of 'Open Game Pad'.
+ *
+ *  The free RAM between the end of .bss and the stack is painted with OG_STACK_CANARY before main() starts. The stack
+ *  overwrites the paint as it grows, so the bytes at the bottom of the free RAM which are still painted are the least free
+ *  stack since power up, with all nested interrupts included. A value that reaches 0 means the stack ran into .bss and
+ *  the V-USB buffers are likely corrupted.
+ *
+ *  Shared by the firmware and the simulation runner, so this header must not depend on AVR headers.
+ * */
+
+#ifndef __STACK_H__
+#define __STACK_H__
+
+#include <stdint.h>
+
+// Paint byte of the free RAM. Any value works as long as the stack rarely writes it right at its deepest point.
+#define OG_STACK_CANARY     0xC5
+
+/* Returns the amount of bytes above .bss which the stack never reached. */
+uint16_t stackFree(void);
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ *  Stick processing of 'Open Game Pad'.
+ * */
+
+#include<avr/pgmspace.h>
+
+#include "stick.h"
+#include "settings.h"
+#include OG_STICK_CURVE
+
+// Longest vector the octagon approximation gives for axes of -128..127.
+#define STICK_RANGE     192
+
+// Entry N is 65536 / N, saturated to 16 bits.
+PROGMEM static const uint16_t RECIP[STICK_RANGE] = {
+    65535, 65535, 32768, 21845, 16384, 13107, 10923,  9362,  8192,  7282,  6554,  5958,
+     5461,  5041,  4681,  4369,  4096,  3855,  3641,  3449,  3277,  3121,  2979,  2849,
+     2731,  2621,  2521,  2427,  2341,  2260,  2185,  2114,  2048,  1986,  1928,  1872,
+     1820,  1771,  1725,  1680,  1638,  1598,  1560,  1524,  1489,  1456,  1425,  1394,
+     1365,  1337,  1311,  1285,  1260,  1237,  1214,  1192,  1170,  1150,  1130,  1111,
+     1092,  1074,  1057,  1040,  1024,  1008,   993,   978,   964,   950,   936,   923,
+      910,   898,   886,   874,   862,   851,   840,   830,   819,   809,   799,   790,
+      780,   771,   762,   753,   745,   736,   728,   720,   712,   705,   697,   690,
+      683,   676,   669,   662,   655,   649,   643,   636,   630,   624,   618,   612,
+      607,   601,   596,   590,   585,   580,   575,   570,   565,   560,   555,   551,
+      546,   542,   537,   533,   529,   524,   520,   516,   512,   508,   504,   500,
+      496,   493,   489,   485,   482,   478,   475,   471,   468,   465,   462,   458,
+      455,   452,   449,   446,   443,   440,   437,   434,   431,   428,   426,   423,
+      420,   417,   415,   412,   410,   407,   405,   402,   400,   397,   395,   392,
+      390,   388,   386,   383,   381,   379,   377,   374,   372,   370,   368,   366,
+      364,   362,   360,   358,   356,   354,   352,   350,   349,   347,   345,   343
+};
+
+// Entry N is N * N / 127.
+PROGMEM static const uint8_t CURVE_QUADRATIC[128] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   1,   2,   2,
+      2,   2,   3,   3,   3,   3,   4,   4,   5,   5,   5,   6,   6,   7,   7,   8,
+      8,   9,   9,  10,  10,  11,  11,  12,  13,  13,  14,  15,  15,  16,  17,  17,
+     18,  19,  20,  20,  21,  22,  23,  24,  25,  26,  26,  27,  28,  29,  30,  31,
+     32,  33,  34,  35,  36,  37,  39,  40,  41,  42,  43,  44,  45,  47,  48,  49,
+     50,  52,  53,  54,  56,  57,  58,  60,  61,  62,  64,  65,  67,  68,  70,  71,
+     73,  74,  76,  77,  79,  80,  82,  84,  85,  87,  88,  90,  92,  94,  95,  97,
+     99, 101, 102, 104, 106, 108, 110, 112, 113, 115, 117, 119, 121, 123, 125, 127
+};
+
+_Static_assert(sizeof(CURVE_CUSTOM) == 128, "custom curve must have 128 entries");
+
+// Scales the axis by 'scale' in 8.8 fixed point, rounded, and saturates it to the report range.
+static int8_t stickScale(int8_t value, uint16_t scale) {
+    int32_t scaled = ((int32_t) value * scale + 0x80) >> 8;
+
+    return scaled > 127 ? 127 : scaled < -127 ? -127 : scaled;
+}
+
+// Sends the stretched length through the response curve.
+static uint8_t stickCurve(uint8_t length, uint8_t curve) {
+    if(curve == OG_CURVE_QUADRATIC) return pgm_read_byte(&CURVE_QUADRATIC[length]);
+    if(curve == OG_CURVE_CUSTOM) return pgm_read_byte(&CURVE_CUSTOM[length]);
+    return length;
+}
+
+void stickApply(int8_t *axes) {
+    for(uint8_t p = 0; p < OG_AXES / 2; p++, axes += 2) {
+        int8_t x = axes[0], y = axes[1];
+        uint8_t ax = x < 0 ? -x : x, ay = y < 0 ? -y : y;
+        uint8_t hi = ax > ay ? ax : ay, lo = ax > ay ? ay : ax;
+        uint8_t radius = hi + (lo >> 2) + (lo >> 3), length;
+        uint8_t dead = TUNING.stickDeadzone[p], outer = TUNING.stickOuter[p];
+
+        if(outer >= STICK_RANGE) outer = STICK_RANGE - 1;
+
+        if(radius <= dead) {
+            axes[0] = axes[1] = 0;
+            continue;
+        }
+        if(radius >= outer || outer <= dead) {
+            length = 127;
+        }else{
+            length = ((uint32_t) (radius - dead) * 127 * pgm_read_word(&RECIP[outer - dead])) >> 16;
+        }
+        length = stickCurve(length, TUNING.stickCurve[p]);
+
+        // New length over the old one, or over the longer axis for the square correction.
+        uint16_t scale = ((uint32_t) length * pgm_read_word(&RECIP[TUNING.stickSquare[p] ? hi : radius]) + 0x80) >> 8;
+
+        axes[0] = stickScale(x, scale);
+        axes[1] = stickScale(y, scale);
+    }
+}
@@ -0,0 +1,28 @@
+/*
+ *  Stick processing of 'Open Game Pad'.
+ *
+ *  Each pair of axes (X/Y of one joystick) is treated as a vector. Its length is found with the octagon approximation
+ *  max + 3/8 min, which stays within 7 % of the true length. The length inside the deadzone gives the center, the length
+ *  beyond the outer ring gives the full deflection and the range in between is stretched to 0..127 and sent through the
+ *  response curve. Both axes are then scaled by the new length over the old one, so the direction is kept. With the
+ *  square correction they are scaled over the longer axis instead, which lets a round gate reach the corners.
+ *
+ *  Divisions are done with a PROGMEM table of reciprocals, curves are PROGMEM tables of 128 entries.
+ * */
+
+#ifndef __STICK_H__
+#define __STICK_H__
+
+#include <stdint.h>
+
+// Response curves of the tuning record.
+enum {
+    OG_CURVE_LINEAR,
+    OG_CURVE_QUADRATIC,
+    OG_CURVE_CUSTOM                 // Table of the board, see OG_STICK_CURVE.
+};
+
+/* Processes the centered axes in place, pair by pair. */
+void stickApply(int8_t *axes);
+
+#endif
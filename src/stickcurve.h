@@ -0,0 +1,17 @@
+/*
+ *  Custom response curve of 'Open Game Pad'.
+ *
+ *  Entry N is the output length for the stretched input length N. The default is a cubic curve, for fine aiming around
+ *  the center with the full range still reachable.
+ * */
+
+PROGMEM static const uint8_t CURVE_CUSTOM[128] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,
+      2,   2,   2,   3,   3,   3,   3,   4,   4,   4,   5,   5,   5,   6,   6,   6,
+      7,   7,   8,   8,   9,   9,  10,  10,  11,  11,  12,  13,  13,  14,  15,  16,
+     16,  17,  18,  19,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  31,
+     32,  33,  34,  35,  37,  38,  39,  41,  42,  44,  45,  47,  48,  50,  51,  53,
+     55,  57,  58,  60,  62,  64,  66,  68,  70,  72,  74,  76,  78,  80,  83,  85,
+     87,  89,  92,  94,  97,  99, 102, 104, 107, 110, 113, 115, 118, 121, 124, 127
+};
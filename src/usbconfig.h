@@ -18,14 +18,17 @@ General Description:
 
 /* ---------------------------- Hardware Config ---------------------------- */
 
+/* The USB lines are given by the hardware backend of the MCU, see hal.h. */
+#include "hal.h"
+
 /* This is the port where the USB bus is connected. When you configure it to
  * "B", the registers PORTB, PINB and DDRB will be used.
  */
-#define USB_CFG_IOPORTNAME      B
+#define USB_CFG_IOPORTNAME      OG_HAL_USB_PORT
 /* This is the bit number in USB_CFG_IOPORT where the USB D- line is connected.
  * This may be any bit in the port.
  */
-#define USB_CFG_DMINUS_BIT      1
+#define USB_CFG_DMINUS_BIT      OG_HAL_USB_DMINUS
 /* This is the bit number in USB_CFG_IOPORT where the USB D+ line is connected.
  * This may be any bit in the port. Please note that D+ must also be connected
  * to interrupt pin INT0! [You can also use other interrupts, see section
@@ -34,7 +37,7 @@ General Description:
  * interrupt, the USB interrupt will also be triggered at Start-Of-Frame
  * markers every millisecond.]
  */
-#define USB_CFG_DPLUS_BIT       2
+#define USB_CFG_DPLUS_BIT       OG_HAL_USB_DPLUS
 /* Clock rate of the AVR in kHz. Legal values are 12000, 12800, 15000, 16000,
  * 16500, 18000 and 20000. The 12.8 MHz and 16.5 MHz versions of the code
  * require no crystal, they tolerate +/- 1% deviation from the nominal
@@ -111,6 +114,12 @@ General Description:
  * device is powered from the USB bus.
  */
 #define USB_CFG_IS_SELF_POWERED         0
+/* Define this to 1 if the device may wake up a suspended host. The
+ * configuration descriptor then advertises remote wakeup, the driver handles
+ * SET_FEATURE/CLEAR_FEATURE DEVICE_REMOTE_WAKEUP and you may call
+ * usbRemoteWakeupSignal() while the host allows it (usbRemoteWakeup).
+ */
+#define USB_CFG_HAVE_REMOTE_WAKEUP      1
 /* Set this variable to the maximum USB bus power consumption of your device.
  * The value is in milliamperes. [It will be divided by two since USB
  * communicates power requirements in units of 2 mA.]
@@ -120,8 +129,8 @@ General Description:
  * transfers. Set it to 0 if you don't need it and want to save a couple of
  * bytes.
  */
-#define USB_CFG_IMPLEMENT_FN_WRITE      0
-#define USB_CFG_IMPLEMENT_FN_READ       0
+#define USB_CFG_IMPLEMENT_FN_WRITE      1
+#define USB_CFG_IMPLEMENT_FN_READ       1
 /* Set this to 1 if you need to send control replies which are generated
  * "on the fly" when usbFunctionRead() is called. If you only want to send
  * data from a static buffer, set it to 0 and return the data from
@@ -155,7 +164,9 @@ General Description:
  * proceed, do a return after doing your things. One possible application
  * (besides debugging) is to flash a status LED on each packet.
  */
+#if OG_HAL_OSCCAL
 #define USB_RESET_HOOK(resetStarts)     if(!resetStarts){hadUsbReset();}
+#endif
 /* This macro is a hook if you need to know when an USB RESET occurs. It has
  * one parameter which distinguishes between the start of RESET state and its
  * end.
@@ -196,17 +207,20 @@ General Description:
  * usbFunctionWrite(). Use the global usbCurrentDataToken and a static variable
  * for each control- and out-endpoint to check for duplicate packets.
  */
-#define USB_CFG_HAVE_MEASURE_FRAME_LENGTH   1
+#define USB_CFG_HAVE_MEASURE_FRAME_LENGTH   OG_HAL_OSCCAL
 /* define this macro to 1 if you want the function usbMeasureFrameLength()
  * compiled in. This function can be used to calibrate the AVR's RC oscillator.
  */
+#ifndef USB_USE_FAST_CRC
 #define USB_USE_FAST_CRC                0
+#endif
 /* The assembler module has two implementations for the CRC algorithm. One is
  * faster, the other is smaller. This CRC routine is only used for transmitted
  * messages where timing is not critical. The faster routine needs 31 cycles
  * per byte while the smaller one needs 61 to 69 cycles. The faster routine
  * may be worth the 32 bytes bigger code size if you transmit lots of data and
  * run the AVR close to its limit.
+ * Can be given on the command line, 'make bench' measures both routines.
  */
 
 /* -------------------------- Device Description --------------------------- */
@@ -277,8 +291,10 @@ General Description:
  * If you use this define, you must add a PROGMEM character array named
  * "usbHidReportDescriptor" to your code which contains the report descriptor.
  * Don't forget to keep the array and this define in sync!
+ * The length is generated from the report table in report.h.
  */
-#define USB_CFG_HID_REPORT_DESCRIPTOR_LENGTH 52
+#include "report.h"
+#define USB_CFG_HID_REPORT_DESCRIPTOR_LENGTH OG_REPORT_DESCRIPTOR_LENGTH
 
 /* #define USB_PUBLIC static */
 /* Use the define above if you #include usbdrv.c instead of linking against it.
@@ -0,0 +1,285 @@
+/*
+ *  Host side uploader for the 'Open Game Pad' HID bootloader.
+ *
+ *  Usage: ogflash main.hex
+ *
+ *  Every pad running the firmware is asked to restart into the bootloader, then every bootloader that shows up gets the
+ *  image, one flash page per feature report (see boot/bootloader.h). Pages that are fully erased in the image are
+ *  skipped, except page 0 which starts a new image. After each page the uploader waits BOOT_PAGE_DELAY, because the
+ *  pad cannot answer while the page is programmed, and then compares the checksum of the programmed page with the
+ *  image. A page the bootloader refused is sent again.
+ *
+ *  The kernel HID driver is detached during the upload, so nothing else polls the pad while its CPU is halted.
+ *
+ *  Both identities use obdev's shared VID/PID pairs, which other V-USB devices use as well. Devices are only taken when
+ *  their manufacturer and product strings match too. A bootloader whose upload failed stays on the bus and is not tried
+ *  again.
+ * */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <libusb.h>
+
+#include "../boot/bootloader.h"
+
+// Firmware USB identity, see src/usbconfig.h.
+#define OG_VID              0x16c0
+#define OG_PID              0x27dc
+#define OG_VENDOR_NAME      "notFtech"
+#define OG_DEVICE_NAME      "OGamePad"
+// HID class requests and the feature report type.
+#define HID_GET_REPORT      0x01
+#define HID_SET_REPORT      0x09
+#define HID_FEATURE         0x0300
+// Timeout of a single control transfer and the time to wait for bootloaders to enumerate, in milliseconds.
+#define USB_TIMEOUT         1000
+#define ENUM_TIMEOUT        5000
+// Most failed bootloaders remembered.
+#define FAILED_MAX          64
+// Attempts to send a page before the upload fails.
+#define PAGE_TRIES          3
+
+// Bus and address of the bootloaders whose upload failed.
+static struct {
+    uint8_t bus, addr;
+} FAILED[FAILED_MAX];
+static int FAILED_COUNT;
+
+static unsigned char IMAGE[BOOT_FLASH_SIZE];
+static unsigned IMAGE_END;
+
+// Reads an Intel HEX file into IMAGE. Returns 0 on success.
+static int hexRead(const char *path) {
+    unsigned len, addr, type, i, b, sum;
+    char line[600], *p;
+    FILE *f = fopen(path, "r");
+
+    if(!f) {
+        perror(path);
+        return -1;
+    }
+    memset(IMAGE, 0xFF, sizeof(IMAGE));
+    while(fgets(line, sizeof(line), f)) {
+        if(line[0] != ':' || sscanf(line + 1, "%2x%4x%2x", &len, &addr, &type) != 3) continue;
+        if(type == 1) break;
+        if(type != 0) continue;
+
+        sum = len + (addr >> 8) + addr + type;
+        for(i = 0, p = line + 9; i <= len; i++, p += 2) {
+            if(sscanf(p, "%2x", &b) != 1) goto broken;
+            sum += b;
+            if(i == len) break;
+            if(addr + i >= sizeof(IMAGE)) {
+                fprintf(stderr, "%s: image does not fit into the flash\n", path);
+                fclose(f);
+                return -1;
+            }
+            IMAGE[addr + i] = b;
+            if(addr + i + 1 > IMAGE_END) IMAGE_END = addr + i + 1;
+        }
+        if(sum & 0xFF) goto broken;
+    }
+    fclose(f);
+    return 0;
+
+broken:
+    fprintf(stderr, "%s: broken record: %s", path, line);
+    fclose(f);
+    return -1;
+}
+
+// Returns non zero if the upload to the device failed before.
+static int deviceFailed(libusb_device *dev) {
+    for(int i = 0; i < FAILED_COUNT; i++) {
+        if(FAILED[i].bus == libusb_get_bus_number(dev) && FAILED[i].addr == libusb_get_device_address(dev)) return 1;
+    }
+
+    return 0;
+}
+
+// Returns non zero if the string descriptor 'index' of the open device reads 'name'.
+static int deviceNamed(libusb_device_handle *h, uint8_t index, const char *name) {
+    unsigned char s[64];
+
+    return index && libusb_get_string_descriptor_ascii(h, index, s, sizeof(s)) > 0 && !strcmp((char *) s, name);
+}
+
+// Opens the device if it has the given identity and names and did not fail before. Returns NULL otherwise.
+static libusb_device_handle *deviceMatch(libusb_device *dev, unsigned short vid, unsigned short pid, const char *vendor,
+    const char *product) {
+    libusb_device_handle *h;
+    struct libusb_device_descriptor d;
+
+    if(libusb_get_device_descriptor(dev, &d) || d.idVendor != vid || d.idProduct != pid) return NULL;
+    if(deviceFailed(dev) || libusb_open(dev, &h)) return NULL;
+    if(!deviceNamed(h, d.iManufacturer, vendor) || !deviceNamed(h, d.iProduct, product)) {
+        libusb_close(h);
+        return NULL;
+    }
+
+    return h;
+}
+
+// Opens the first device with the given identity and names that did not fail before. Returns NULL if there is none.
+static libusb_device_handle *deviceOpen(unsigned short vid, unsigned short pid, const char *vendor,
+    const char *product) {
+    libusb_device_handle *h = NULL;
+    libusb_device **list;
+    ssize_t i, n = libusb_get_device_list(NULL, &list);
+
+    for(i = 0; i < n && !h; i++) h = deviceMatch(list[i], vid, pid, vendor, product);
+    libusb_free_device_list(list, 1);
+
+    return h;
+}
+
+/*
+ * Asks every pad running the firmware to restart into the bootloader. Returns the amount of pads asked.
+ *
+ * The bus is listed once and every pad in that list is asked. Pads leave the bus while the others are asked, so a list
+ * taken again would no longer line up with the pads already asked.
+ * */
+static int padsRestart(void) {
+    libusb_device_handle *h;
+    libusb_device **list;
+    ssize_t i, count = libusb_get_device_list(NULL, &list);
+    int n = 0;
+
+    for(i = 0; i < count; i++) {
+        if(!(h = deviceMatch(list[i], OG_VID, OG_PID, OG_VENDOR_NAME, OG_DEVICE_NAME))) continue;
+        libusb_control_transfer(h, LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE | LIBUSB_ENDPOINT_OUT,
+            BOOT_RQ_ENTER, 0, 0, NULL, 0, USB_TIMEOUT);
+        libusb_close(h);
+        n++;
+    }
+    libusb_free_device_list(list, 1);
+
+    return n;
+}
+
+// CRC-16 step of the page checksum, the same as _crc_ccitt_update() of avr-libc.
+static uint16_t crcUpdate(uint16_t crc, uint8_t data) {
+    data ^= crc & 0xFF;
+    data ^= data << 4;
+
+    return ((uint16_t) data << 8 | crc >> 8) ^ (uint8_t) (data >> 4) ^ ((uint16_t) data << 3);
+}
+
+// Checksum of the page as the bootloader programs it. Its reset vector always jumps to the bootloader at 'boot'.
+static uint16_t pageCrc(unsigned page, unsigned boot) {
+    uint16_t crc = 0xFFFF, reset = BOOT_RJMP(0, boot);
+
+    for(unsigned i = 0; i < BOOT_PAGE_SIZE; i++) {
+        crc = crcUpdate(crc, page == 0 && i < 2 ? (uint8_t) (reset >> 8 * i) : IMAGE[page + i]);
+    }
+
+    return crc;
+}
+
+// Reads the info report of the bootloader. Returns 0 on success.
+static int padInfo(libusb_device_handle *h, unsigned char *info) {
+    int r = libusb_control_transfer(h, LIBUSB_REQUEST_TYPE_CLASS | LIBUSB_RECIPIENT_INTERFACE | LIBUSB_ENDPOINT_IN,
+        HID_GET_REPORT, HID_FEATURE, 0, info, BOOT_INFO_SIZE, USB_TIMEOUT);
+
+    return r == BOOT_INFO_SIZE && info[0] == BOOT_PAGE_SIZE ? 0 : -1;
+}
+
+// Uploads the image to one bootloader. Returns 0 on success.
+static int padFlash(libusb_device_handle *h) {
+    unsigned char info[BOOT_INFO_SIZE], report[BOOT_REPORT_SIZE];
+    unsigned page, boot, i, pages = 0;
+    int r, tries, result = -1;
+
+    libusb_set_auto_detach_kernel_driver(h, 1);
+    if((r = libusb_claim_interface(h, 0))) {
+        fprintf(stderr, "cannot claim the bootloader: %s\n", libusb_strerror(r));
+        return -1;
+    }
+    if(padInfo(h, info)) {
+        fprintf(stderr, "unexpected bootloader info\n");
+        goto release;
+    }
+    boot = info[1] | info[2] << 8;
+    // The last word below the bootloader holds the jump into the firmware.
+    if(IMAGE_END > boot - 2) {
+        fprintf(stderr, "image of %u bytes overlaps the bootloader at 0x%04x\n", IMAGE_END, boot);
+        goto release;
+    }
+
+    for(page = 0; page < IMAGE_END; page += BOOT_PAGE_SIZE) {
+        for(i = 0; page && i < BOOT_PAGE_SIZE && IMAGE[page + i] == 0xFF; i++);
+        if(i == BOOT_PAGE_SIZE) continue;
+
+        report[0] = page;
+        report[1] = page >> 8;
+        memcpy(report + 2, IMAGE + page, BOOT_PAGE_SIZE);
+        // The bootloader stalls a report while it still has to program the previous page.
+        for(tries = 0; tries < PAGE_TRIES; tries++) {
+            r = libusb_control_transfer(h, LIBUSB_REQUEST_TYPE_CLASS | LIBUSB_RECIPIENT_INTERFACE | LIBUSB_ENDPOINT_OUT,
+                HID_SET_REPORT, HID_FEATURE, 0, report, sizeof(report), USB_TIMEOUT);
+            usleep(BOOT_PAGE_DELAY * 1000);
+            if(r == sizeof(report)) break;
+        }
+        if(r != sizeof(report)) {
+            fprintf(stderr, "page 0x%04x failed: %s\n", page, r < 0 ? libusb_strerror(r) : "short transfer");
+            goto release;
+        }
+        if(padInfo(h, info) || (info[3] | info[4] << 8) != pageCrc(page, boot)) {
+            fprintf(stderr, "page 0x%04x does not read back as written\n", page);
+            goto release;
+        }
+        pages++;
+    }
+
+    // The pad restarts into the firmware right after this report, so its status may never arrive.
+    memset(report, 0, sizeof(report));
+    report[0] = report[1] = BOOT_ADDR_LEAVE & 0xFF;
+    libusb_control_transfer(h, LIBUSB_REQUEST_TYPE_CLASS | LIBUSB_RECIPIENT_INTERFACE | LIBUSB_ENDPOINT_OUT,
+        HID_SET_REPORT, HID_FEATURE, 0, report, sizeof(report), USB_TIMEOUT);
+    printf("%u pages written\n", pages);
+    result = 0;
+
+release:
+    libusb_release_interface(h, 0);
+    return result;
+}
+
+int main(int argc, char **argv) {
+    libusb_device_handle *h;
+    int waited = 0, flashed = 0, failed = 0;
+
+    if(argc != 2) {
+        fprintf(stderr, "usage: %s main.hex\n", argv[0]);
+        return 2;
+    }
+    if(hexRead(argv[1]) || libusb_init(NULL)) return 1;
+
+    printf("%d pads restarted into the bootloader\n", padsRestart());
+    // Bootloaders are flashed one after another until no new one shows up.
+    while(waited < ENUM_TIMEOUT) {
+        if(!(h = deviceOpen(BOOT_VID, BOOT_PID, BOOT_VENDOR_NAME, BOOT_DEVICE_NAME))) {
+            usleep(100 * 1000);
+            waited += 100;
+            continue;
+        }
+        if(padFlash(h)) {
+            // The pad stays in the bootloader, it is left for the next run.
+            FAILED[FAILED_COUNT].bus = libusb_get_bus_number(libusb_get_device(h));
+            FAILED[FAILED_COUNT].addr = libusb_get_device_address(libusb_get_device(h));
+            FAILED_COUNT++;
+            failed++;
+        }else{
+            flashed++;
+        }
+        libusb_close(h);
+        if(FAILED_COUNT == FAILED_MAX) break;
+        waited = 0;
+        usleep(500 * 1000);                 // Letting the pad leave the bootloader before looking for the next one.
+    }
+    printf("%d pads updated, %d failed\n", flashed, failed);
+    libusb_exit(NULL);
+
+    return failed || !flashed;
+}
@@ -118,6 +118,12 @@ section at the end of this file).
 /* Define this to 1 if the device has its own power supply. Set it to 0 if the
  * device is powered from the USB bus.
  */
+#define USB_CFG_HAVE_REMOTE_WAKEUP      0
+/* Define this to 1 if the device may wake up a suspended host. The
+ * configuration descriptor then advertises remote wakeup, the driver handles
+ * SET_FEATURE/CLEAR_FEATURE DEVICE_REMOTE_WAKEUP and you may call
+ * usbRemoteWakeupSignal() while the host allows it (usbRemoteWakeup).
+ */
 #define USB_CFG_MAX_BUS_POWER           100
 /* Set this variable to the maximum USB bus power consumption of your device.
  * The value is in milliamperes. [It will be divided by two since USB
@@ -9,6 +9,9 @@
 
 #include "usbdrv.h"
 #include "oddebug.h"
+#if USB_CFG_HAVE_REMOTE_WAKEUP
+#include <util/delay.h>
+#endif
 
 /*
 General Description:
@@ -24,6 +27,9 @@ uchar       usbInputBufOffset;  /* offset in usbRxBuf used for low level receivi
 uchar       usbDeviceAddr;      /* assigned during enumeration, defaults to 0 */
 uchar       usbNewDeviceAddr;   /* device ID which should be set after status phase */
 uchar       usbConfiguration;   /* currently selected configuration. Administered by driver, but not used */
+#if USB_CFG_HAVE_REMOTE_WAKEUP
+uchar       usbRemoteWakeup;    /* host allows the device to wake it up */
+#endif
 volatile schar usbRxLen;        /* = 0; number of bytes in usbRxBuf; 0 means free, -1 for flow control */
 uchar       usbCurrentTok;      /* last token received or endpoint number for last OUT token if != 0 */
 uchar       usbRxToken;         /* token for data we received; or endpont number for last OUT */
@@ -147,10 +153,11 @@ PROGMEM const char usbDescriptorConfiguration[] = {    /* USB configuration desc
     1,          /* index of this configuration */
     0,          /* configuration name string index */
 #if USB_CFG_IS_SELF_POWERED
-    (1 << 7) | USBATTR_SELFPOWER,       /* attributes */
+    (1 << 7) | USBATTR_SELFPOWER |      /* attributes */
 #else
-    (1 << 7),                           /* attributes */
+    (1 << 7) |                          /* attributes */
 #endif
+        (USB_CFG_HAVE_REMOTE_WAKEUP ? USBATTR_REMOTEWAKE : 0),
     USB_CFG_MAX_BUS_POWER/2,            /* max USB current in 2mA units */
 /* interface descriptor follows inline: */
     9,          /* sizeof(usbDescrInterface): length of descriptor in bytes */
@@ -372,18 +379,28 @@ uchar   index = rq->wIndex.bytes[0];
         uchar recipient = rq->bmRequestType & USBRQ_RCPT_MASK;  /* assign arith ops to variables to enforce byte size */
         if(USB_CFG_IS_SELF_POWERED && recipient == USBRQ_RCPT_DEVICE)
             dataPtr[0] =  USB_CFG_IS_SELF_POWERED;
+#if USB_CFG_HAVE_REMOTE_WAKEUP
+        if(recipient == USBRQ_RCPT_DEVICE)
+            dataPtr[0] |= usbRemoteWakeup << 1;
+#endif
 #if USB_CFG_IMPLEMENT_HALT
         if(recipient == USBRQ_RCPT_ENDPOINT && index == 0x81)   /* request status for endpoint 1 */
             dataPtr[0] = usbTxLen1 == USBPID_STALL;
 #endif
         dataPtr[1] = 0;
         len = 2;
-#if USB_CFG_IMPLEMENT_HALT
+#if USB_CFG_IMPLEMENT_HALT || USB_CFG_HAVE_REMOTE_WAKEUP
     SWITCH_CASE2(USBRQ_CLEAR_FEATURE, USBRQ_SET_FEATURE)    /* 1, 3 */
+#if USB_CFG_HAVE_REMOTE_WAKEUP
+        if(value == 1 && (rq->bmRequestType & USBRQ_RCPT_MASK) == USBRQ_RCPT_DEVICE) /* feature 1 == DEVICE_REMOTE_WAKEUP */
+            usbRemoteWakeup = rq->bRequest == USBRQ_SET_FEATURE;
+#endif
+#if USB_CFG_IMPLEMENT_HALT
         if(value == 0 && index == 0x81){    /* feature 0 == HALT for endpoint == 1 */
             usbTxLen1 = rq->bRequest == USBRQ_CLEAR_FEATURE ? USBPID_NAK : USBPID_STALL;
             usbResetDataToggling();
         }
+#endif
 #endif
     SWITCH_CASE(USBRQ_SET_ADDRESS)          /* 5 */
         usbNewDeviceAddr = value;
@@ -599,6 +616,9 @@ uchar   i;
     /* RESET condition, called multiple times during reset */
     usbNewDeviceAddr = 0;
     usbDeviceAddr = 0;
+#if USB_CFG_HAVE_REMOTE_WAKEUP
+    usbRemoteWakeup = 0;
+#endif
     usbResetStall();
     DBG1(0xff, 0, 0);
 isNotReset:
@@ -607,6 +627,23 @@ isNotReset:
 
 /* ------------------------------------------------------------------------- */
 
+#if USB_CFG_HAVE_REMOTE_WAKEUP
+USB_PUBLIC void usbRemoteWakeupSignal(void)
+{
+uchar   i;
+
+    USBOUT = (USBOUT & ~USBMASK) | (1 << USBPLUS);  /* K state of a low speed bus */
+    USBDDR |= USBMASK;
+    for(i = 10; i > 0; i--)     /* resume signalling lasts 1 to 15 ms */
+        _delay_ms(1);
+    USBDDR &= ~USBMASK;
+    USBOUT &= ~USBMASK;
+    USB_INTR_PENDING = 1 << USB_INTR_PENDING_BIT;   /* our own edges are no packet */
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+
 USB_PUBLIC void usbInit(void)
 {
 #if USB_INTR_CFG_SET != 0
@@ -9,7 +9,7 @@
 
 #ifndef __usbdrv_h_included__
 #define __usbdrv_h_included__
-#include "../src/usbconfig.h"
+#include "usbconfig.h"
 #include "usbportability.h"
 
 /*
@@ -347,6 +347,18 @@ extern uchar    usbConfiguration;
  * You may want to reflect the "configured" status with a LED on the device or
  * switch on high power parts of the circuit only if the device is configured.
  */
+#if USB_CFG_HAVE_REMOTE_WAKEUP
+extern uchar    usbRemoteWakeup;
+/* This value is non-zero while the host allows the device to wake it up
+ * (SET_FEATURE DEVICE_REMOTE_WAKEUP). It is cleared on every bus reset.
+ */
+USB_PUBLIC void usbRemoteWakeupSignal(void);
+/* This function drives resume signalling on the bus for 10 ms. Call it with
+ * interrupts disabled, only while usbRemoteWakeup is set and only after the
+ * bus was idle for at least 5 ms. The host answers with its own resume
+ * signalling and the bus becomes active again.
+ */
+#endif
 #if USB_COUNT_SOF
 extern volatile uchar   usbSofCount;
 /* This variable is incremented on every SOF packet. It is only available if
@@ -572,6 +584,10 @@ int usbDescriptorStringSerialNumber[];
 #define USB_CFG_HAVE_INTRIN_ENDPOINT3   0
 #endif
 
+#ifndef USB_CFG_HAVE_REMOTE_WAKEUP
+#define USB_CFG_HAVE_REMOTE_WAKEUP      0
+#endif
+
 #define USB_BUFSIZE     11  /* PID, 8 bytes data, 2 bytes CRC */
 
 /* ----- Try to find registers and bits responsible for ext interrupt 0 ----- */